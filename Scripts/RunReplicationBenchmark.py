@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# Copyright Epic Games, Inc. All Rights Reserved.
+
+"""
+Measures server replication time for the Shooter replication graph at several connection counts.
+
+For every connection count, starts a headless dedicated server with -ShooterRepBenchmark=N, connects N
+headless clients to it and waits for the server to exit. The server records once every client has joined
+and writes its CSV to Saved/Profiling/ShooterRepBenchmark, see UShooterReplicationGraph.
+
+Example:
+    python Scripts/RunReplicationBenchmark.py --engine "C:/UE_5.6/Engine/Binaries/Win64/UnrealEditor-Cmd.exe"
+"""
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+import time
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="Shooter replication graph benchmark")
+    parser.add_argument("--engine", required=True, help="path to UnrealEditor-Cmd")
+    parser.add_argument("--project", default=os.path.join(PROJECT_DIR, "FirstPersonDemo.uproject"), help="project file")
+    parser.add_argument("--map", default="/Game/Variant_Shooter/Lvl_Shooter", help="map the server hosts")
+    parser.add_argument("--counts", type=int, nargs="+", default=[16, 32, 64], help="connection counts to measure")
+    parser.add_argument("--seconds", type=float, default=30.0, help="time recorded once every client has joined")
+    parser.add_argument("--port", type=int, default=7777, help="server port")
+    parser.add_argument("--join-timeout", type=float, default=300.0, help="time allowed for every client to join, on top of the recording time")
+    return parser.parse_args()
+
+
+def base_command(args):
+    command = [args.engine]
+    if args.project:
+        command.append(args.project)
+    return command
+
+
+def run_count(args, num_connections):
+    server_command = base_command(args) + [
+        args.map,
+        "-server",
+        "-nullrhi",
+        "-unattended",
+        "-log",
+        "-port={}".format(args.port),
+        "-ShooterRepBenchmark={}".format(num_connections),
+        "-ShooterRepBenchmarkSeconds={}".format(args.seconds),
+        "-LOG=RepBenchmarkServer_{}.log".format(num_connections),
+    ]
+
+    print("[{} connections] starting server".format(num_connections))
+    server = subprocess.Popen(server_command)
+
+    # give the server time to load the map before the clients knock
+    time.sleep(10.0)
+
+    clients = []
+    for i in range(num_connections):
+        client_command = base_command(args) + [
+            "127.0.0.1:{}".format(args.port),
+            "-game",
+            "-nullrhi",
+            "-nosound",
+            "-unattended",
+            "-LOG=RepBenchmarkClient_{}.log".format(i),
+        ]
+        clients.append(subprocess.Popen(client_command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL))
+
+    print("[{} connections] {} clients launched, waiting for the server to finish".format(num_connections, len(clients)))
+
+    try:
+        server.wait(timeout=args.join_timeout + args.seconds)
+    except subprocess.TimeoutExpired:
+        print("[{} connections] server timed out, not every client joined".format(num_connections))
+        server.kill()
+
+    for client in clients:
+        if client.poll() is None:
+            client.kill()
+
+    for client in clients:
+        client.wait()
+
+    return server.returncode
+
+
+def main():
+    args = parse_args()
+
+    failed = []
+    for num_connections in args.counts:
+        if run_count(args, num_connections) != 0:
+            failed.append(num_connections)
+
+    reports = sorted(glob.glob(os.path.join(PROJECT_DIR, "Saved", "Profiling", "ShooterRepBenchmark", "*.csv")))
+    print("Reports in Saved/Profiling/ShooterRepBenchmark:")
+    for report in reports:
+        print("  " + os.path.basename(report))
+
+    if failed:
+        print("No clean run for: {}".format(", ".join(str(count) for count in failed)))
+        return 1
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
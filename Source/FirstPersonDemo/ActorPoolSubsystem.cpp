@@ -0,0 +1,301 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ActorPoolSubsystem.h"
+#include "PoolableActor.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "FirstPersonDemo.h"
+
+DECLARE_STATS_GROUP(TEXT("ActorPool"), STATGROUP_ActorPool, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Hits"), STAT_ActorPoolHits, STATGROUP_ActorPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Misses"), STAT_ActorPoolMisses, STATGROUP_ActorPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actors In Flight"), STAT_ActorPoolInFlight, STATGROUP_ActorPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Peak Actors In Flight"), STAT_ActorPoolPeakInFlight, STATGROUP_ActorPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Free Actors"), STAT_ActorPoolFree, STATGROUP_ActorPool);
+
+static FAutoConsoleCommandWithWorld GActorPoolDumpCommand(
+	TEXT("ActorPool.Dump"),
+	TEXT("Logs the hit, miss and in-flight counters for every pooled actor class"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UActorPoolSubsystem* Pool = World ? World->GetSubsystem<UActorPoolSubsystem>() : nullptr)
+		{
+			Pool->DumpStats();
+		}
+	}));
+
+bool UActorPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UActorPoolSubsystem::Prewarm(TSubclassOf<AActor> ActorClass, int32 Count)
+{
+	if (!ActorClass)
+	{
+		return;
+	}
+
+	FActorPoolBucket& Bucket = Buckets.FindOrAdd(ActorClass.Get());
+
+	// only spawn the actors we're missing
+	const int32 NumToSpawn = Count - (Bucket.FreeActors.Num() + Bucket.Stats.InFlight);
+
+	for (int32 i = 0; i < NumToSpawn; ++i)
+	{
+		if (AActor* NewActor = SpawnPooledActor(ActorClass, FTransform::Identity, nullptr, nullptr))
+		{
+			DeactivateActor(NewActor);
+			Bucket.FreeActors.Add(NewActor);
+		}
+	}
+
+	Bucket.Stats.Free = Bucket.FreeActors.Num();
+
+	UpdateInFlightStats();
+}
+
+AActor* UActorPoolSubsystem::AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform, AActor* Owner, APawn* Instigator)
+{
+	if (!ActorClass)
+	{
+		return nullptr;
+	}
+
+	FActorPoolBucket& Bucket = Buckets.FindOrAdd(ActorClass.Get());
+
+	AActor* Actor = nullptr;
+
+	// pop actors off the free list until we find one that's still valid
+	while (!Actor && Bucket.FreeActors.Num() > 0)
+	{
+		Actor = Bucket.FreeActors.Pop(EAllowShrinking::No);
+
+		if (!IsValid(Actor))
+		{
+			Actor = nullptr;
+		}
+	}
+
+	if (Actor)
+	{
+		// reuse the pooled actor
+		ActivateActor(Actor, Transform, Owner, Instigator);
+
+		++Bucket.Stats.Hits;
+		INC_DWORD_STAT(STAT_ActorPoolHits);
+
+	} else {
+
+		// the pool is dry, so spawn a fresh actor
+		Actor = SpawnPooledActor(ActorClass, Transform, Owner, Instigator);
+
+		++Bucket.Stats.Misses;
+		INC_DWORD_STAT(STAT_ActorPoolMisses);
+	}
+
+	if (Actor)
+	{
+		Bucket.InFlightActors.Add(Actor);
+
+		++Bucket.Stats.InFlight;
+		Bucket.Stats.PeakInFlight = FMath::Max(Bucket.Stats.PeakInFlight, Bucket.Stats.InFlight);
+	}
+
+	Bucket.Stats.Free = Bucket.FreeActors.Num();
+
+	UpdateInFlightStats();
+
+	return Actor;
+}
+
+void UActorPoolSubsystem::ReleaseActor(AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return;
+	}
+
+	FActorPoolBucket* Bucket = Buckets.Find(Actor->GetClass());
+
+	if (!Bucket || !Bucket->InFlightActors.Remove(Actor))
+	{
+		// already back in the pool, nothing to do
+		if (Bucket && Bucket->FreeActors.Contains(Actor))
+		{
+			UE_LOG(LogFirstPersonDemo, Warning, TEXT("ActorPool: %s was released twice"), *GetNameSafe(Actor));
+			return;
+		}
+
+		// spawned outside the pool. Adopting it would grow the free list with every direct spawn, so get rid of it
+		Actor->Destroy();
+		return;
+	}
+
+	DeactivateActor(Actor);
+
+	Bucket->FreeActors.Add(Actor);
+
+	Bucket->Stats.InFlight = FMath::Max(Bucket->Stats.InFlight - 1, 0);
+	Bucket->Stats.Free = Bucket->FreeActors.Num();
+
+	UpdateInFlightStats();
+}
+
+FActorPoolStats UActorPoolSubsystem::GetStats(TSubclassOf<AActor> ActorClass) const
+{
+	if (const FActorPoolBucket* Bucket = Buckets.Find(ActorClass.Get()))
+	{
+		return Bucket->Stats;
+	}
+
+	return FActorPoolStats();
+}
+
+void UActorPoolSubsystem::DumpStats() const
+{
+	for (const TPair<TObjectPtr<UClass>, FActorPoolBucket>& Pair : Buckets)
+	{
+		const FActorPoolStats& Stats = Pair.Value.Stats;
+
+		UE_LOG(LogFirstPersonDemo, Log, TEXT("ActorPool [%s] Hits=%d Misses=%d InFlight=%d PeakInFlight=%d Free=%d"),
+			*GetNameSafe(Pair.Key), Stats.Hits, Stats.Misses, Stats.InFlight, Stats.PeakInFlight, Stats.Free);
+	}
+}
+
+int32 UActorPoolSubsystem::AddLiveCount(FName Counter, int32 Delta)
+{
+	int32& Count = LiveCounts.FindOrAdd(Counter);
+	Count = FMath::Max(Count + Delta, 0);
+
+	return Count;
+}
+
+void UActorPoolSubsystem::ReleaseOrDestroy(AActor* Actor)
+{
+	if (!IsValid(Actor))
+	{
+		return;
+	}
+
+	if (UActorPoolSubsystem* Pool = Actor->GetWorld() ? Actor->GetWorld()->GetSubsystem<UActorPoolSubsystem>() : nullptr)
+	{
+		Pool->ReleaseActor(Actor);
+
+	} else {
+
+		Actor->Destroy();
+	}
+}
+
+AActor* UActorPoolSubsystem::SpawnPooledActor(UClass* ActorClass, const FTransform& Transform, AActor* Owner, APawn* Instigator)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::OverrideRootScale;
+	SpawnParams.Owner = Owner;
+	SpawnParams.Instigator = Instigator;
+
+	AActor* NewActor = GetWorld()->SpawnActor<AActor>(ActorClass, Transform, SpawnParams);
+
+	// pooled actors can still be destroyed directly, by gameplay code or by falling out of the world
+	if (NewActor)
+	{
+		NewActor->OnDestroyed.AddDynamic(this, &UActorPoolSubsystem::OnPooledActorDestroyed);
+	}
+
+	return NewActor;
+}
+
+void UActorPoolSubsystem::OnPooledActorDestroyed(AActor* DestroyedActor)
+{
+	FActorPoolBucket* Bucket = Buckets.Find(DestroyedActor->GetClass());
+
+	if (!Bucket)
+	{
+		return;
+	}
+
+	// an actor destroyed while handed out will never be released
+	if (Bucket->InFlightActors.Remove(DestroyedActor))
+	{
+		Bucket->Stats.InFlight = FMath::Max(Bucket->Stats.InFlight - 1, 0);
+
+	} else {
+
+		Bucket->FreeActors.RemoveSingleSwap(DestroyedActor, EAllowShrinking::No);
+	}
+
+	Bucket->Stats.Free = Bucket->FreeActors.Num();
+
+	UpdateInFlightStats();
+}
+
+void UActorPoolSubsystem::DeactivateActor(AActor* Actor) const
+{
+	// let the actor reset its own state first
+	if (IPoolableActor* Poolable = Cast<IPoolableActor>(Actor))
+	{
+		Poolable->OnReturnedToPool();
+	}
+
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+
+	// pooled actors don't need to use any bandwidth until they're reused
+	if (Actor->GetIsReplicated() && Actor->HasAuthority())
+	{
+		Actor->SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void UActorPoolSubsystem::ActivateActor(AActor* Actor, const FTransform& Transform, AActor* Owner, APawn* Instigator) const
+{
+	// wake the actor up on the network before changing any replicated state
+	if (Actor->GetIsReplicated() && Actor->HasAuthority())
+	{
+		Actor->SetNetDormancy(DORM_Awake);
+	}
+
+	Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	Actor->SetOwner(Owner);
+	Actor->SetInstigator(Instigator);
+
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+
+	// tick the way a freshly spawned actor of this class would. Classes that only tick on demand start out disabled
+	Actor->SetActorTickEnabled(Actor->GetClass()->GetDefaultObject<AActor>()->PrimaryActorTick.bStartWithTickEnabled);
+
+	// let the actor restore its own state
+	if (IPoolableActor* Poolable = Cast<IPoolableActor>(Actor))
+	{
+		Poolable->OnAcquiredFromPool();
+	}
+
+	Actor->ForceNetUpdate();
+}
+
+void UActorPoolSubsystem::UpdateInFlightStats() const
+{
+#if STATS
+	int32 InFlight = 0;
+	int32 PeakInFlight = 0;
+	int32 Free = 0;
+
+	for (const TPair<TObjectPtr<UClass>, FActorPoolBucket>& Pair : Buckets)
+	{
+		InFlight += Pair.Value.Stats.InFlight;
+		PeakInFlight += Pair.Value.Stats.PeakInFlight;
+		Free += Pair.Value.Stats.Free;
+	}
+
+	SET_DWORD_STAT(STAT_ActorPoolInFlight, InFlight);
+	SET_DWORD_STAT(STAT_ActorPoolPeakInFlight, PeakInFlight);
+	SET_DWORD_STAT(STAT_ActorPoolFree, Free);
+#endif
+}
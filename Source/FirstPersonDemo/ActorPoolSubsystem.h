@@ -0,0 +1,129 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ActorPoolSubsystem.generated.h"
+
+class APawn;
+
+/**
+ *  Usage counters for a single pooled actor class
+ */
+USTRUCT(BlueprintType)
+struct FActorPoolStats
+{
+	GENERATED_BODY()
+
+	/** Number of acquires served from the free list */
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 Hits = 0;
+
+	/** Number of acquires that had to spawn a new actor */
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 Misses = 0;
+
+	/** Number of actors currently handed out */
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 InFlight = 0;
+
+	/** Highest number of actors handed out at the same time */
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 PeakInFlight = 0;
+
+	/** Number of actors waiting in the free list */
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 Free = 0;
+};
+
+/**
+ *  Free list and counters for a single pooled actor class
+ */
+USTRUCT()
+struct FActorPoolBucket
+{
+	GENERATED_BODY()
+
+	/** Deactivated actors ready to be handed out */
+	UPROPERTY()
+	TArray<TObjectPtr<AActor>> FreeActors;
+
+	/** Actors currently handed out. Only these are taken back on release */
+	TSet<TObjectKey<AActor>> InFlightActors;
+
+	/** Usage counters for this class */
+	FActorPoolStats Stats;
+};
+
+/**
+ *  World subsystem that recycles actors instead of spawning and destroying them
+ *  Actors are grouped per class. Pooled classes should implement IPoolableActor
+ *  so they can reset their state when they're handed out and returned
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UActorPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Pooled actors, grouped by class */
+	UPROPERTY()
+	TMap<TObjectPtr<UClass>, FActorPoolBucket> Buckets;
+
+	/** Live actor counters kept by pooled classes, by name. Unlike the bucket stats they also count actors spawned outside the pool */
+	TMap<FName, int32> LiveCounts;
+
+public:
+
+	/** Ensures at least the given number of actors of the class exist in the pool, counting the ones in flight */
+	void Prewarm(TSubclassOf<AActor> ActorClass, int32 Count);
+
+	/** Hands out an actor of the given class, reusing a pooled one if available */
+	AActor* AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform, AActor* Owner, APawn* Instigator);
+
+	/** Typed version of AcquireActor */
+	template<class T>
+	T* Acquire(TSubclassOf<T> ActorClass, const FTransform& Transform, AActor* Owner, APawn* Instigator)
+	{
+		return Cast<T>(AcquireActor(ActorClass, Transform, Owner, Instigator));
+	}
+
+	/** Returns an actor to the pool. Actors the pool didn't hand out are destroyed, so the free list never grows past the peak in flight */
+	void ReleaseActor(AActor* Actor);
+
+	/** Returns the usage counters for the given class */
+	FActorPoolStats GetStats(TSubclassOf<AActor> ActorClass) const;
+
+	/** Writes the usage counters for every pooled class to the log */
+	void DumpStats() const;
+
+	/** Adds to a named live actor counter and returns the new count */
+	int32 AddLiveCount(FName Counter, int32 Delta);
+
+	/** Returns a named live actor counter */
+	int32 GetLiveCount(FName Counter) const { return LiveCounts.FindRef(Counter); }
+
+	/** Static helper that releases the actor to its world's pool, or destroys it if no pool is available */
+	static void ReleaseOrDestroy(AActor* Actor);
+
+protected:
+
+	/** Only create the pool for game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Spawns a new actor for the pool and starts watching for it being destroyed */
+	AActor* SpawnPooledActor(UClass* ActorClass, const FTransform& Transform, AActor* Owner, APawn* Instigator);
+
+	/** Forgets a pooled actor that was destroyed outside the pool, so it no longer counts as in flight or free */
+	UFUNCTION()
+	void OnPooledActorDestroyed(AActor* DestroyedActor);
+
+	/** Hides and disables an actor while it waits in the pool */
+	void DeactivateActor(AActor* Actor) const;
+
+	/** Re-enables an actor handed out by the pool */
+	void ActivateActor(AActor* Actor, const FTransform& Transform, AActor* Owner, APawn* Instigator) const;
+
+	/** Updates the global stat counters from the buckets */
+	void UpdateInFlightStats() const;
+};
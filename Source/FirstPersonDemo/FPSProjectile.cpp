@@ -2,13 +2,17 @@
 
 
 #include "FPSProjectile.h"
+#include "ActorPoolSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
 
 
 // Sets default values
 AFPSProjectile::AFPSProjectile()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// ֻƶͼʱҪÿ֡Tick
+	PrimaryActorTick.bCanEverTick = false;
 	if (!RootComponent) {
 		RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
 	}
@@ -48,31 +52,49 @@ AFPSProjectile::AFPSProjectile()
 		{
 			ProjectileMeshComponent->SetStaticMesh(Mesh.Object);
 		}
+		ProjectileMeshComponent->SetRelativeScale3D(FVector(0.09f, 0.09f, 0.09f));
+		ProjectileMeshComponent->SetupAttachment(RootComponent);
 	}
 
-	static ConstructorHelpers::FObjectFinder<UMaterial>Material(TEXT("'/Game/Weapons/GrenadeLauncher/Materials/M_GrenadeLauncher.M_GrenadeLauncher'"));
+	// зﹲͬһʣΪÿﴴ̬ʵ
+	static ConstructorHelpers::FObjectFinder<UMaterialInterface>Material(TEXT("'/Game/Weapons/GrenadeLauncher/Materials/M_GrenadeLauncher.M_GrenadeLauncher'"));
 	if (Material.Succeeded())
 	{
-		ProjectileMaterialInstance = UMaterialInstanceDynamic::Create(Material.Object, ProjectileMeshComponent);
-		ProjectileMeshComponent->SetMaterial(0, ProjectileMaterialInstance);
-		ProjectileMeshComponent->SetRelativeScale3D(FVector(0.09f, 0.09f, 0.09f));
-		ProjectileMeshComponent->SetupAttachment(RootComponent);
+		ProjectileMeshComponent->SetMaterial(0, Material.Object);
 	}
-	InitialLifeSpan = 3.0f; // ÷Ϊ3
+
+	// ɼʱƣں黹ض
+	InitialLifeSpan = 0.0f;
 }
 
 // Called when the game starts or when spawned
 void AFPSProjectile::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	// ֱɵķڽʱɶ
+	if (ProjectileLifetime > 0.0f)
+	{
+		GetWorld()->GetTimerManager().SetTimer(LifetimeTimer, this, &AFPSProjectile::OnLifetimeExpired, ProjectileLifetime, false);
+	}
 }
 
-// Called every frame
-void AFPSProjectile::Tick(float DeltaTime)
+AFPSProjectile* AFPSProjectile::FireFromPool(const UObject* WorldContextObject, TSubclassOf<AFPSProjectile> ProjectileClass, const FTransform& SpawnTransform, const FVector& ShootDirection, APawn* ShotInstigator)
 {
-	Super::Tick(DeltaTime);
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UActorPoolSubsystem* Pool = World ? World->GetSubsystem<UActorPoolSubsystem>() : nullptr;
+	if (!Pool)
+	{
+		return nullptr;
+	}
 
+	AFPSProjectile* Projectile = Pool->Acquire<AFPSProjectile>(ProjectileClass, SpawnTransform, ShotInstigator, ShotInstigator);
+	if (Projectile)
+	{
+		Projectile->FireInDirection(ShootDirection);
+	}
+
+	return Projectile;
 }
 
 void AFPSProjectile::FireInDirection(const FVector& ShootDirection)
@@ -80,15 +102,70 @@ void AFPSProjectile::FireInDirection(const FVector& ShootDirection)
 	ProjectileMovementComponent->Velocity = ShootDirection * ProjectileMovementComponent->InitialSpeed;
 }
 
+void AFPSProjectile::SetProjectileTint(const FLinearColor& Tint)
+{
+	// ͨPerInstanceCustomDataȡɫҪ̬ʵ
+	ProjectileMeshComponent->SetCustomPrimitiveDataVector4(0, FVector4(Tint));
+}
+
 // ʱô˺
 void AFPSProjectile::OnHit(UPrimitiveComponent* HitCompoent, AActor* OtherActor, UPrimitiveComponent* OtherComponent, FVector NormalImpulse, const FHitResult& Hit)
 {
+	// ͬһ֡ڿжײѾ黹ķﲻٴ
+	if (bReleased)
+	{
+		return;
+	}
+
 	// Ч
-	if (OtherActor != this && OtherComponent->IsSimulatingPhysics())
+	if (OtherActor != this && OtherComponent && OtherComponent->IsSimulatingPhysics())
 	{
 		// ӻЧ粥Ч
 		OtherComponent->AddImpulseAtLocation(ProjectileMovementComponent->Velocity * 10.0f, Hit.ImpactPoint); // ʩӳ
 	}
-	// ٷ
-	Destroy();
-}
\ No newline at end of file
+	// 黹
+	ReleaseProjectile();
+}
+
+void AFPSProjectile::OnLifetimeExpired()
+{
+	ReleaseProjectile();
+}
+
+void AFPSProjectile::ReleaseProjectile()
+{
+	// ֹظ黹
+	if (bReleased)
+	{
+		return;
+	}
+
+	bReleased = true;
+
+	UActorPoolSubsystem::ReleaseOrDestroy(this);
+}
+
+void AFPSProjectile::OnAcquiredFromPool()
+{
+	bReleased = false;
+
+	// ¼ƶٶFireInDirection
+	ProjectileMovementComponent->SetUpdatedComponent(CollisionComponent);
+	ProjectileMovementComponent->Velocity = GetActorForwardVector() * ProjectileMovementComponent->InitialSpeed;
+	ProjectileMovementComponent->Activate(true);
+
+	// ¿ʼ
+	if (ProjectileLifetime > 0.0f)
+	{
+		GetWorld()->GetTimerManager().SetTimer(LifetimeTimer, this, &AFPSProjectile::OnLifetimeExpired, ProjectileLifetime, false);
+	}
+}
+
+void AFPSProjectile::OnReturnedToPool()
+{
+	// ֹͣʱƶȴ´ʹ
+	GetWorld()->GetTimerManager().ClearTimer(LifetimeTimer);
+
+	ProjectileMovementComponent->StopMovementImmediately();
+	ProjectileMovementComponent->Deactivate();
+}
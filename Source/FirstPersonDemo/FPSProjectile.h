@@ -6,14 +6,15 @@
 #include "GameFramework/Actor.h"
 #include "Components/SphereComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
+#include "PoolableActor.h"
 #include "FPSProjectile.generated.h"
 
 UCLASS()
-class FIRSTPERSONDEMO_API AFPSProjectile : public AActor
+class FIRSTPERSONDEMO_API AFPSProjectile : public AActor, public IPoolableActor
 {
 	GENERATED_BODY()
-	
-public:	
+
+public:
 	// Sets default values for this actor's properties
 	AFPSProjectile();
 
@@ -21,17 +22,40 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	// ڽʱѷ黹
+	void OnLifetimeExpired();
+
+	// ѷ黹أûжʱֱ
+	void ReleaseProjectile();
+
+	// ڼʱ
+	FTimerHandle LifetimeTimer;
+
+	// ǷѾ黹أͬһ֡ײʱظ黹
+	bool bReleased = false;
+
+public:
+	// Ӷȡﲢ䣬ΪʱŻµķ
+	UFUNCTION(BlueprintCallable, Category = Projectile, meta = (WorldContext = "WorldContextObject"))
+	static AFPSProjectile* FireFromPool(const UObject* WorldContextObject, TSubclassOf<AFPSProjectile> ProjectileClass, const FTransform& SpawnTransform, const FVector& ShootDirection, APawn* ShotInstigator);
 
 	// ʼϷٶ
 	void FireInDirection(const FVector& ShootDirection);
 
+	// ÷ɫдԶͼԪݣзﹲͬһ
+	UFUNCTION(BlueprintCallable, Category = Projectile)
+	void SetProjectileTint(const FLinearColor& Tint);
+
 	// ʱô˺
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitCompoent, AActor* OtherActor, UPrimitiveComponent* OtherComponent, FVector NormalImpulse, const FHitResult& Hit);
 
+	// Ӷȡʱ¿ʼƶͼʱ
+	virtual void OnAcquiredFromPool() override;
+
+	// 黹ʱֹͣƶͼʱ
+	virtual void OnReturnedToPool() override;
+
 	// ײ
 	UPROPERTY(VisibleDefaultsOnly, Category = Projectile)
 	USphereComponent* CollisionComponent;
@@ -44,9 +68,9 @@ public:
 	UPROPERTY(VisibleDefaultsOnly, Category = Projectile)
 	UStaticMeshComponent* ProjectileMeshComponent;
 
-	// 
-	UPROPERTY(VisibleDefaultsOnly, Category = Movement)
-	UMaterialInstanceDynamic* ProjectileMaterialInstance;
-	
-	
+	// ڣں黹
+	UPROPERTY(EditDefaultsOnly, Category = Projectile, meta = (ClampMin = 0, Units = "s"))
+	float ProjectileLifetime = 3.0f;
+
+
 };
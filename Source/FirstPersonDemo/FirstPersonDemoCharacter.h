@@ -58,7 +58,9 @@ protected:
 	//TSubclassOf<class AFPSProjectile> ProjectileClass;
 
 public:
-	AFirstPersonDemoCharacter();
+
+	/** Constructor. Takes an object initializer so variants can swap in their own movement component */
+	AFirstPersonDemoCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
 protected:
 
@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "PoolableActor.generated.h"
+
+// This class does not need to be modified.
+UINTERFACE(MinimalAPI)
+class UPoolableActor : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ *  Common interface for actors that can be recycled by the UActorPoolSubsystem
+ *  Pooled actors are spawned once and then handed out and returned many times
+ */
+class FIRSTPERSONDEMO_API IPoolableActor
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Called when the actor is handed out by the pool. Transform, owner and instigator have already been set */
+	virtual void OnAcquiredFromPool() = 0;
+
+	/** Called when the actor is returned to the pool. Should stop movement, collision and any pending timers */
+	virtual void OnReturnedToPool() = 0;
+};
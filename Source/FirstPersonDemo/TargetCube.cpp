@@ -3,6 +3,7 @@
 
 #include "TargetCube.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 
 // Sets default values
@@ -39,6 +40,7 @@ void ATargetCube::BeginPlay()
 		CubeMesh->SetEnableGravity(true);
 		// 
 		Score = FMath::RandRange(1, 2);
+		MARK_PROPERTY_DIRTY_FROM_NAME(ATargetCube, Score, this);
 
 		OnRep_Score();
 	}
@@ -80,6 +82,7 @@ void ATargetCube::OnProjectileHit(AShooterCharacter* ShooterChar)
 	}
 	// ӻд
 	HitCount++;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ATargetCube, HitCount, this);
 	// һλʱŴ󷽿
 	if (HitCount == 1)
 	{	
@@ -169,7 +172,10 @@ void ATargetCube::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifet
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ATargetCube, Score);
-	DOREPLIFETIME(ATargetCube, HitCount);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(ATargetCube, Score, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ATargetCube, HitCount, Params);
 }
 
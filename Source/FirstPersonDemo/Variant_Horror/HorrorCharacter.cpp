@@ -9,8 +9,10 @@
 #include "Components/SpotLightComponent.h"
 #include "EnhancedInputComponent.h"
 #include "InputAction.h"
+#include "HorrorCharacterMovementComponent.h"
 
-AHorrorCharacter::AHorrorCharacter()
+AHorrorCharacter::AHorrorCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UHorrorCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// create the spotlight
 	SpotLight = CreateDefaultSubobject<USpotLightComponent>(TEXT("SpotLight"));
@@ -28,22 +30,31 @@ void AHorrorCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// initialize sprint meter to max
-	SprintMeter = SprintTime;
-
-	// Initialize the walk speed
-	GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
-
-	// start the sprint tick timer
-	GetWorld()->GetTimerManager().SetTimer(SprintTimer, this, &AHorrorCharacter::SprintFixedTick, SprintFixedTickTime, true);
+	// hand the walk and sprint settings to the movement component, which fills the sprint meter
+	GetHorrorMovement()->SetSprintSettings(WalkSpeed, SprintSpeed, RecoveringWalkSpeed, SprintTime);
 }
 
-void AHorrorCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
+void AHorrorCharacter::Tick(float DeltaSeconds)
 {
-	Super::EndPlay(EndPlayReason);
+	Super::Tick(DeltaSeconds);
+
+	const UHorrorCharacterMovementComponent* HorrorMovement = GetHorrorMovement();
 
-	// clear the sprint timer
-	GetWorld()->GetTimerManager().ClearTimer(SprintTimer);
+	// call the sprint state changed delegate when we start or stop sprinting, including running out of stamina
+	if (HorrorMovement->IsSprinting() != bSprinting)
+	{
+		bSprinting = HorrorMovement->IsSprinting();
+		OnSprintStateChanged.Broadcast(bSprinting);
+	}
+
+	// broadcast the sprint meter updated delegate
+	const float SprintMeterPercent = HorrorMovement->GetStaminaPercent();
+
+	if (SprintMeterPercent != LastSprintMeterPercent)
+	{
+		LastSprintMeterPercent = SprintMeterPercent;
+		OnSprintMeterUpdated.Broadcast(SprintMeterPercent);
+	}
 }
 
 void AHorrorCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -64,80 +75,16 @@ void AHorrorCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCom
 
 void AHorrorCharacter::DoStartSprint()
 {
-	// set the sprinting flag
-	bSprinting = true;
-
-	// are we out of recovery mode?
-	if (!bRecovering)
-	{
-		// set the sprint walk speed
-		GetCharacterMovement()->MaxWalkSpeed = SprintSpeed;
-
-		// call the sprint state changed delegate
-		OnSprintStateChanged.Broadcast(true);
-	}
-
+	// the movement component sends the sprint intent to the server with every move
+	GetHorrorMovement()->SetWantsToSprint(true);
 }
 
 void AHorrorCharacter::DoEndSprint()
 {
-	// set the sprinting flag
-	bSprinting = false;
-
-	// are we out of recovery mode?
-	if (!bRecovering)
-	{
-		// set the default walk speed
-		GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
-
-		// call the sprint state changed delegate
-		OnSprintStateChanged.Broadcast(false);
-	}
+	GetHorrorMovement()->SetWantsToSprint(false);
 }
 
-void AHorrorCharacter::SprintFixedTick()
+UHorrorCharacterMovementComponent* AHorrorCharacter::GetHorrorMovement() const
 {
-	// are we out of recovery, still have stamina and are moving faster than our walk speed?
-	if (bSprinting && !bRecovering && GetVelocity().Length() > WalkSpeed)
-	{
-
-		// do we still have meter to burn?
-		if (SprintMeter > 0.0f)
-		{
-			// update the sprint meter
-			SprintMeter = FMath::Max(SprintMeter - SprintFixedTickTime, 0.0f);
-
-			// have we run out of stamina?
-			if (SprintMeter <= 0.0f)
-			{
-				// raise the recovering flag
-				bRecovering = true;
-
-				// set the recovering walk speed
-				GetCharacterMovement()->MaxWalkSpeed = RecoveringWalkSpeed;
-			}
-		}
-		
-	} else {
-
-		// recover stamina
-		SprintMeter = FMath::Min(SprintMeter + SprintFixedTickTime, SprintTime);
-
-		if (SprintMeter >= SprintTime)
-		{
-			// lower the recovering flag
-			bRecovering = false;
-
-			// set the walk or sprint speed depending on whether the sprint button is down
-			GetCharacterMovement()->MaxWalkSpeed = bSprinting ? SprintSpeed : WalkSpeed;
-
-			// update the sprint state depending on whether the button is down or not
-			OnSprintStateChanged.Broadcast(bSprinting);
-		}
-
-	}
-
-	// broadcast the sprint meter updated delegate
-	OnSprintMeterUpdated.Broadcast(SprintMeter / SprintTime);
-
+	return CastChecked<UHorrorCharacterMovementComponent>(GetCharacterMovement());
 }
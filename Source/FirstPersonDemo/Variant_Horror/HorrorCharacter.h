@@ -8,13 +8,14 @@
 
 class USpotLightComponent;
 class UInputAction;
+class UHorrorCharacterMovementComponent;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FUpdateSprintMeterDelegate, float, Percentage);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FSprintStateChangedDelegate, bool, bSprinting);
 
 /**
  *  Simple first person horror character
- *  Provides stamina-based sprinting
+ *  Provides stamina-based sprinting, predicted by its movement component
  */
 UCLASS(abstract)
 class FIRSTPERSONDEMO_API AHorrorCharacter : public AFirstPersonDemoCharacter
@@ -31,23 +32,16 @@ protected:
 	UPROPERTY(EditAnywhere, Category ="Input")
 	UInputAction* SprintAction;
 
-	/** If true, we're sprinting */
+	/** Sprint state last broadcast to the UI */
 	bool bSprinting = false;
 
-	/** If true, we're recovering stamina */
-	bool bRecovering = false;
+	/** Sprint meter last broadcast to the UI */
+	float LastSprintMeterPercent = -1.0f;
 
 	/** Default walk speed when not sprinting or recovering */
 	UPROPERTY(EditAnywhere, Category="Walk")
 	float WalkSpeed = 250.0f;
 
-	/** Time interval for sprinting stamina ticks */
-	UPROPERTY(EditAnywhere, Category="Sprint", meta = (ClampMin = 0, ClampMax = 1, Units = "s"))
-	float SprintFixedTickTime = 0.03333f;
-
-	/** Sprint stamina amount. Maxes at SprintTime */
-	float SprintMeter = 0.0f;
-
 	/** How long we can sprint for, in seconds */
 	UPROPERTY(EditAnywhere, Category="Sprint", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
 	float SprintTime = 3.0f;
@@ -64,9 +58,6 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Recovery", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
 	float RecoveryTime = 0.0f;
 
-	/** Sprint tick timer */
-	FTimerHandle SprintTimer;
-
 public:
 
 	/** Delegate called when the sprint meter should be updated */
@@ -78,13 +69,13 @@ public:
 protected:
 
 	/** Constructor */
-	AHorrorCharacter();
+	AHorrorCharacter(const FObjectInitializer& ObjectInitializer);
 
 	/** Gameplay initialization */
 	virtual void BeginPlay() override;
 
-	/** Gameplay cleanup */
-	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+	/** Updates the sprint UI from the movement component */
+	virtual void Tick(float DeltaSeconds) override;
 
 	/** Set up input action bindings */
 	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
@@ -99,6 +90,6 @@ protected:
 	UFUNCTION(BlueprintCallable, Category="Input")
 	void DoEndSprint();
 
-	/** Called while sprinting at a fixed time interval */
-	void SprintFixedTick();
+	/** Returns the movement component cast to its horror type */
+	UHorrorCharacterMovementComponent* GetHorrorMovement() const;
 };
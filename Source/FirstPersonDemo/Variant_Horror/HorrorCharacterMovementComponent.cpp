@@ -0,0 +1,208 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "HorrorCharacterMovementComponent.h"
+#include "GameFramework/Character.h"
+
+void FHorrorMoveResponseDataContainer::ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment)
+{
+	Super::ServerFillResponseData(CharacterMovement, PendingAdjustment);
+
+	const UHorrorCharacterMovementComponent& HorrorMovement = static_cast<const UHorrorCharacterMovementComponent&>(CharacterMovement);
+
+	Stamina = HorrorMovement.GetStamina();
+	bRecovering = HorrorMovement.IsRecovering();
+}
+
+bool FHorrorMoveResponseDataContainer::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap)
+{
+	if (!Super::Serialize(CharacterMovement, Ar, PackageMap))
+	{
+		return false;
+	}
+
+	// good moves don't need the stamina, the client already predicted it
+	if (IsCorrection())
+	{
+		Ar << Stamina;
+
+		uint8 bRecoveringBit = bRecovering ? 1 : 0;
+		Ar.SerializeBits(&bRecoveringBit, 1);
+		bRecovering = bRecoveringBit != 0;
+	}
+
+	return !Ar.IsError();
+}
+
+UHorrorCharacterMovementComponent::UHorrorCharacterMovementComponent()
+{
+	SetMoveResponseDataContainer(HorrorMoveResponseData);
+}
+
+void UHorrorCharacterMovementComponent::SetSprintSettings(float InWalkSpeed, float InSprintSpeed, float InRecoveringWalkSpeed, float InMaxStamina)
+{
+	MaxWalkSpeed = InWalkSpeed;
+	SprintSpeed = InSprintSpeed;
+	RecoveringWalkSpeed = InRecoveringWalkSpeed;
+	MaxStamina = InMaxStamina;
+
+	// start with full stamina
+	Stamina = MaxStamina;
+	bRecovering = false;
+}
+
+float UHorrorCharacterMovementComponent::GetMaxSpeed() const
+{
+	if (IsMovingOnGround())
+	{
+		if (bRecovering)
+		{
+			return RecoveringWalkSpeed;
+		}
+
+		if (bWantsToSprint)
+		{
+			return SprintSpeed;
+		}
+	}
+
+	return Super::GetMaxSpeed();
+}
+
+FNetworkPredictionData_Client* UHorrorCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (!ClientPredictionData)
+	{
+		UHorrorCharacterMovementComponent* MutableThis = const_cast<UHorrorCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Horror(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UHorrorCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+}
+
+void UHorrorCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	// are we out of recovery, still have stamina and are moving faster than our walk speed?
+	if (bWantsToSprint && !bRecovering && Velocity.Size() > MaxWalkSpeed)
+	{
+		// burn stamina for this move
+		Stamina = FMath::Max(Stamina - DeltaSeconds, 0.0f);
+
+		// have we run out?
+		if (Stamina <= 0.0f)
+		{
+			bRecovering = true;
+		}
+
+	} else {
+
+		// recover stamina
+		Stamina = FMath::Min(Stamina + DeltaSeconds, MaxStamina);
+
+		// recovery lasts until the meter is full again
+		if (Stamina >= MaxStamina)
+		{
+			bRecovering = false;
+		}
+	}
+}
+
+void UHorrorCharacterMovementComponent::ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse)
+{
+	// the pending moves are replayed from the corrected state, so it needs the server's stamina too
+	if (MoveResponse.IsCorrection())
+	{
+		const FHorrorMoveResponseDataContainer& HorrorResponse = static_cast<const FHorrorMoveResponseDataContainer&>(MoveResponse);
+
+		Stamina = HorrorResponse.Stamina;
+		bRecovering = HorrorResponse.bRecovering;
+	}
+
+	Super::ClientHandleMoveResponse(MoveResponse);
+}
+
+bool UHorrorCharacterMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	// replayed moves read the sprint intent from their flags, so keep the live input around them
+	const bool bRealWantsToSprint = bWantsToSprint;
+
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+
+	bWantsToSprint = bRealWantsToSprint;
+
+	return bResult;
+}
+
+void FSavedMove_Horror::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToSprint = false;
+	StartStamina = 0.0f;
+	bStartRecovering = false;
+}
+
+uint8 FSavedMove_Horror::GetCompressedFlags() const
+{
+	uint8 Flags = Super::GetCompressedFlags();
+
+	if (bSavedWantsToSprint)
+	{
+		Flags |= FLAG_Custom_0;
+	}
+
+	return Flags;
+}
+
+bool FSavedMove_Horror::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	if (bSavedWantsToSprint != static_cast<const FSavedMove_Horror*>(NewMove.Get())->bSavedWantsToSprint)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Horror::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
+{
+	Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+	// the combined move is performed again from the start of the old one, so rewind the stamina too
+	const FSavedMove_Horror* OldHorrorMove = static_cast<const FSavedMove_Horror*>(OldMove);
+
+	StartStamina = OldHorrorMove->StartStamina;
+	bStartRecovering = OldHorrorMove->bStartRecovering;
+
+	if (UHorrorCharacterMovementComponent* Movement = Cast<UHorrorCharacterMovementComponent>(InCharacter->GetCharacterMovement()))
+	{
+		Movement->Stamina = StartStamina;
+		Movement->bRecovering = bStartRecovering;
+	}
+}
+
+void FSavedMove_Horror::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	if (const UHorrorCharacterMovementComponent* Movement = Cast<UHorrorCharacterMovementComponent>(C->GetCharacterMovement()))
+	{
+		bSavedWantsToSprint = Movement->bWantsToSprint;
+		StartStamina = Movement->Stamina;
+		bStartRecovering = Movement->bRecovering;
+	}
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Horror::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Horror());
+}
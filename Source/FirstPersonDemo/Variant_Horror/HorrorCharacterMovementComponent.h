@@ -0,0 +1,151 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/CharacterMovementReplication.h"
+#include "HorrorCharacterMovementComponent.generated.h"
+
+/**
+ *  Move response that also carries the server's stamina state when it corrects the client
+ */
+struct FHorrorMoveResponseDataContainer : public FCharacterMoveResponseDataContainer
+{
+	using Super = FCharacterMoveResponseDataContainer;
+
+	/** Server stamina after the corrected move */
+	float Stamina = 0.0f;
+
+	/** Server recovery state after the corrected move */
+	bool bRecovering = false;
+
+	/** Copies the stamina state from the server movement component */
+	virtual void ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment) override;
+
+	/** Adds the stamina state to corrections */
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap) override;
+};
+
+/**
+ *  Character movement with stamina based sprinting
+ *  Sprint intent travels in the compressed move flags and stamina is integrated as part of every move,
+ *  so the owning client predicts its sprint speed exactly and the server only corrects it when something else went wrong
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UHorrorCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_Horror;
+
+	/** Response data used for moves sent back to the owning client */
+	FHorrorMoveResponseDataContainer HorrorMoveResponseData;
+
+protected:
+
+	/** If true, the sprint button is held */
+	bool bWantsToSprint = false;
+
+	/** If true, the stamina ran out and we're walking slowly until it fills back up */
+	bool bRecovering = false;
+
+	/** Stamina left, in seconds of sprinting */
+	float Stamina = 0.0f;
+
+	/** Stamina when full, in seconds of sprinting */
+	float MaxStamina = 3.0f;
+
+	/** Walk speed while sprinting */
+	float SprintSpeed = 600.0f;
+
+	/** Walk speed while recovering stamina */
+	float RecoveringWalkSpeed = 150.0f;
+
+public:
+
+	/** Constructor */
+	UHorrorCharacterMovementComponent();
+
+	/** Sets up the sprint speeds and stamina, and fills the stamina up */
+	void SetSprintSettings(float InWalkSpeed, float InSprintSpeed, float InRecoveringWalkSpeed, float InMaxStamina);
+
+	/** Sets the sprint intent. Sent to the server with the next move */
+	void SetWantsToSprint(bool bSprint) { bWantsToSprint = bSprint; }
+
+	/** Returns true if we're sprinting, as opposed to just holding the button while recovering */
+	bool IsSprinting() const { return bWantsToSprint && !bRecovering; }
+
+	/** Returns true if we're recovering stamina */
+	bool IsRecovering() const { return bRecovering; }
+
+	/** Returns the stamina left, in seconds of sprinting */
+	float GetStamina() const { return Stamina; }
+
+	/** Returns the stamina left as a fraction of the max stamina */
+	float GetStaminaPercent() const { return MaxStamina > 0.0f ? Stamina / MaxStamina : 0.0f; }
+
+	/** Uses the sprint or recovering speeds while on the ground */
+	virtual float GetMaxSpeed() const override;
+
+	/** Allocates the saved moves that carry the sprint intent */
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+
+	/** Reads the sprint intent from the move flags */
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
+	/** Burns or recovers stamina for the move about to be performed */
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	/** Takes the server's stamina state from a correction before the pending moves are replayed */
+	virtual void ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse) override;
+
+	/** Keeps the live sprint input while the pending moves are replayed */
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+};
+
+/**
+ *  Saved move with the sprint intent
+ */
+class FSavedMove_Horror : public FSavedMove_Character
+{
+	using Super = FSavedMove_Character;
+
+public:
+
+	/** Sprint intent for this move */
+	uint8 bSavedWantsToSprint : 1;
+
+	/** Stamina before this move. Restored when this move absorbs an older pending one so the stamina isn't burned twice */
+	float StartStamina = 0.0f;
+
+	/** Recovery state before this move */
+	uint8 bStartRecovering : 1;
+
+	virtual void Clear() override;
+
+	virtual uint8 GetCompressedFlags() const override;
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+	virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation) override;
+
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+
+};
+
+/**
+ *  Client prediction data that allocates horror saved moves
+ */
+class FNetworkPredictionData_Client_Horror : public FNetworkPredictionData_Client_Character
+{
+	using Super = FNetworkPredictionData_Client_Character;
+
+public:
+
+	FNetworkPredictionData_Client_Horror(const UCharacterMovementComponent& ClientMovement) : Super(ClientMovement) {}
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
@@ -8,14 +8,17 @@
 #include "AIController.h"
 #include "BrainComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "Camera/CameraComponent.h"
-#include "Kismet/KismetMathLibrary.h"
 #include "Engine/World.h"
 #include "ShooterGameMode.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "TimerManager.h"
+#include "ShooterLagCompensation.h"
+#include "ShooterDamage.h"
+#include "UObject/ObjectSaveContext.h"
 
 
 AShooterNPC::AShooterNPC()
@@ -28,6 +31,12 @@ void AShooterNPC::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// dedicated servers never render the first person mesh and place shots with the analytic muzzle, so skip its animation
+	if (GetNetMode() == NM_DedicatedServer && bHasBakedWeaponSocket)
+	{
+		GetFirstPersonMesh()->SetComponentTickEnabled(false);
+	}
+
 	// ¼Ĭƶٶȣʱָ
 	if (UCharacterMovementComponent* MoveComp = GetCharacterMovement())
 	{
@@ -54,14 +63,26 @@ void AShooterNPC::BeginPlay()
 	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 
 	Weapon = GetWorld()->SpawnActor<AShooterWeapon>(WeaponClass, GetActorTransform(), SpawnParams);
+
+	// record our hitbox history so player hitscan shots can be lag compensated
+	if (HasAuthority())
+	{
+		if (UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
+	}
 }
 
 void AShooterNPC::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShooterNPC, CurrentHP);
-	DOREPLIFETIME(AShooterNPC, bIsDead);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterNPC, CurrentHP, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterNPC, bIsDead, Params);
 }
 
 void AShooterNPC::OnRep_CurrentHP()
@@ -76,6 +97,12 @@ void AShooterNPC::EndPlay(const EEndPlayReason::Type EndPlayReason)
 
 	// clear the death timer
 	GetWorld()->GetTimerManager().ClearTimer(DeathTimer);
+
+	// stop recording our hitbox history
+	if (UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
 }
 
 float AShooterNPC::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
@@ -92,8 +119,25 @@ float AShooterNPC::TakeDamage(float Damage, struct FDamageEvent const& DamageEve
 		return 0.0f;
 	}
 
-	// ¼һζ NPC ˺Ŀڽɱӷ֣
-	LastHitInstigator = EventInstigator;
+	// collect the hit, it gets applied together with the rest of this frame's damage
+	if (DamageAccumulator.AddDamage(Damage, EventInstigator, CurrentHP, GetWorld()->GetTimeSeconds()))
+	{
+		UShooterDamageSubsystem::QueueTarget(this);
+	}
+
+	return Damage;
+}
+
+void AShooterNPC::ResolvePendingDamage()
+{
+	AController* KillingInstigator = nullptr;
+	const float Damage = DamageAccumulator.ConsumePendingDamage(GetWorld()->GetTimeSeconds(), KillingInstigator);
+
+	// we may have died since the damage was queued
+	if (bIsDead || Damage <= 0.0f)
+	{
+		return;
+	}
 
 	// ѪȨ
 	CurrentHP -= Damage;
@@ -101,11 +145,14 @@ float AShooterNPC::TakeDamage(float Damage, struct FDamageEvent const& DamageEve
 	// Ѫж
 	if (CurrentHP <= 0.0f)
 	{
+		// ¼һζ NPC ˺Ŀڽɱӷ֣
+		LastHitInstigator = KillingInstigator;
+
 		CurrentHP = 0.0f;
 		Die();
 	}
 
-	return Damage;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterNPC, CurrentHP, this);
 }
 
 void AShooterNPC::OnPreGameCountdownUpdated(int32 NewTime)
@@ -222,6 +269,9 @@ FVector AShooterNPC::GetWeaponTargetLocation()
 
 	FVector AimDir, AimTarget = FVector::ZeroVector;
 
+	// roll the aim jitter from the weapon's stream for the upcoming shot, so the shot can be reproduced
+	const FRandomStream AimStream = Weapon ? Weapon->GetShotStream(Weapon->GetNextShotId(), EShooterShotStream::Aim) : FRandomStream(0);
+
 	// do we have an aim target?
 	if (CurrentAimTarget)
 	{
@@ -229,17 +279,17 @@ FVector AShooterNPC::GetWeaponTargetLocation()
 		AimTarget = CurrentAimTarget->GetActorLocation();
 
 		// apply a vertical offset to target head/feet
-		AimTarget.Z += FMath::RandRange(MinAimOffsetZ, MaxAimOffsetZ);
+		AimTarget.Z += AimStream.FRandRange(MinAimOffsetZ, MaxAimOffsetZ);
 
 		// get the aim direction and apply randomness in a cone
 		AimDir = (AimTarget - AimSource).GetSafeNormal();
-		AimDir = UKismetMathLibrary::RandomUnitVectorInConeInDegrees(AimDir, AimVarianceHalfAngle);
+		AimDir = AimStream.VRandCone(AimDir, FMath::DegreesToRadians(AimVarianceHalfAngle));
 
 		
 	} else {
 
 		// no aim target, so just use the camera facing
-		AimDir = UKismetMathLibrary::RandomUnitVectorInConeInDegrees(GetFirstPersonCameraComponent()->GetForwardVector(), AimVarianceHalfAngle);
+		AimDir = AimStream.VRandCone(GetFirstPersonCameraComponent()->GetForwardVector(), FMath::DegreesToRadians(AimVarianceHalfAngle));
 
 	}
 
@@ -258,6 +308,28 @@ FVector AShooterNPC::GetWeaponTargetLocation()
 	return OutHit.bBlockingHit ? OutHit.ImpactPoint : OutHit.TraceEnd;
 }
 
+void AShooterNPC::GetWeaponAimView(FVector& OutViewLocation, FRotator& OutViewRotation)
+{
+	// aim from the eyes along the controller rotation, so nothing here depends on animation
+	OutViewLocation = GetPawnViewLocation();
+	OutViewRotation = GetBaseAimRotation();
+}
+
+bool AShooterNPC::GetBakedWeaponSocket(FTransform& OutSocketTransform) const
+{
+	OutSocketTransform = BakedWeaponSocket;
+	return bHasBakedWeaponSocket;
+}
+
+#if WITH_EDITOR
+void AShooterNPC::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	bHasBakedWeaponSocket = BakeWeaponSocket(this, GetFirstPersonMesh(), FirstPersonWeaponSocket, BakedWeaponSocket);
+}
+#endif
+
 void AShooterNPC::AddWeaponClass(const TSubclassOf<AShooterWeapon>& InWeaponClass)
 {
 	// unused
@@ -292,6 +364,7 @@ void AShooterNPC::Die()
 	}
 
 	bIsDead = true;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterNPC, bIsDead, this);
 
 	// ====== ɱڶ +20  ======
 	if (AShooterGameMode* GM = Cast<AShooterGameMode>(GetWorld()->GetAuthGameMode()))
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "FirstPersonDemoCharacter.h"
 #include "ShooterWeaponHolder.h"
+#include "ShooterDamage.h"
 #include "ShooterNPC.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FPawnDeathDelegate);
@@ -19,7 +20,7 @@ class AShooterGameState;
  *  Holds and manages a weapon
  */
 UCLASS(abstract)
-class FIRSTPERSONDEMO_API AShooterNPC : public AFirstPersonDemoCharacter, public IShooterWeaponHolder
+class FIRSTPERSONDEMO_API AShooterNPC : public AFirstPersonDemoCharacter, public IShooterWeaponHolder, public IShooterDamageTarget
 {
 	GENERATED_BODY()
 
@@ -60,6 +61,14 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category ="Weapons")
 	FName ThirdPersonWeaponSocket = FName("HandGrip_R");
 
+	/** First person weapon socket relative to the eye view, in the first person mesh reference pose. Baked when the NPC is saved */
+	UPROPERTY(VisibleAnywhere, Category ="Weapons")
+	FTransform BakedWeaponSocket;
+
+	/** If true, the weapon socket has been baked */
+	UPROPERTY(VisibleAnywhere, Category ="Weapons")
+	bool bHasBakedWeaponSocket = false;
+
 	/** Max range for aiming calculations */
 	UPROPERTY(EditAnywhere, Category="Aim")
 	float AimRange = 10000.0f;
@@ -105,6 +114,9 @@ protected:
 	UPROPERTY()
 	AController* LastHitInstigator = nullptr;
 
+	/** Damage taken this frame and the recent hit history. Server only */
+	FShooterDamageAccumulator DamageAccumulator;
+
 	/** Ѫͬʱͻ˻صܻ֣ */
 	UFUNCTION()
 	void OnRep_CurrentHP();
@@ -132,6 +144,11 @@ protected:
 	/** Gameplay cleanup */
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+#if WITH_EDITOR
+	/** Bakes the weapon socket so cooked builds never need to evaluate the first person mesh for it */
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#endif
+
 public:
 
 	/** Handle incoming damage */
@@ -156,6 +173,12 @@ public:
 	/** Calculates and returns the aim location for the weapon */
 	virtual FVector GetWeaponTargetLocation() override;
 
+	/** Returns the view the weapon is aimed from */
+	virtual void GetWeaponAimView(FVector& OutViewLocation, FRotator& OutViewRotation) override;
+
+	/** Returns the weapon socket baked from the first person mesh */
+	virtual bool GetBakedWeaponSocket(FTransform& OutSocketTransform) const override;
+
 	/** Gives a weapon of this class to the owner */
 	virtual void AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override;
 
@@ -170,6 +193,16 @@ public:
 
 	//~End IShooterWeaponHolder interface
 
+	//~Begin IShooterDamageTarget interface
+
+	/** Applies all the damage accumulated this frame in one go */
+	virtual void ResolvePendingDamage() override;
+
+	/** Returns true once the NPC has died */
+	virtual bool IsDead() const override { return bIsDead; }
+
+	//~End IShooterDamageTarget interface
+
 protected:
 
 	/** Called when HP is depleted and the character should die */
@@ -0,0 +1,152 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterNoise.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+#include "Perception/AISense_Hearing.h"
+#include "HAL/IConsoleManager.h"
+#include "FirstPersonDemo.h"
+
+DECLARE_STATS_GROUP(TEXT("ShooterNoise"), STATGROUP_ShooterNoise, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Raw Noise Events"), STAT_NoiseRaw, STATGROUP_ShooterNoise);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Emitted Noise Events"), STAT_NoiseEmitted, STATGROUP_ShooterNoise);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pending Noises"), STAT_NoisePending, STATGROUP_ShooterNoise);
+
+static TAutoConsoleVariable<float> CVarNoiseMergeWindow(
+	TEXT("Shooter.NoiseMergeWindow"),
+	0.1f,
+	TEXT("Time in seconds noises from the same instigator are merged over before they're reported to AI perception"));
+
+static TAutoConsoleVariable<float> CVarNoiseMergeRadius(
+	TEXT("Shooter.NoiseMergeRadius"),
+	300.0f,
+	TEXT("Max distance in cm between two noises from the same instigator for them to be merged"));
+
+static FAutoConsoleCommandWithWorld GNoiseDumpCommand(
+	TEXT("Shooter.NoiseDump"),
+	TEXT("Logs how many AI noises were reported and how many stimuli reached AI perception"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UShooterNoiseSubsystem* Noise = World ? World->GetSubsystem<UShooterNoiseSubsystem>() : nullptr)
+		{
+			Noise->DumpMetrics();
+		}
+	}));
+
+void UShooterNoiseSubsystem::ReportNoise(AActor* NoiseMaker, float Loudness, APawn* NoiseInstigator, const FVector& Location, float MaxRange, FName Tag)
+{
+	if (!NoiseMaker)
+	{
+		return;
+	}
+
+	if (UShooterNoiseSubsystem* Noise = NoiseMaker->GetWorld()->GetSubsystem<UShooterNoiseSubsystem>())
+	{
+		Noise->QueueNoise(Loudness, NoiseInstigator, Location, MaxRange, Tag);
+		return;
+	}
+
+	NoiseMaker->MakeNoise(Loudness, NoiseInstigator, Location, MaxRange, Tag);
+}
+
+void UShooterNoiseSubsystem::QueueNoise(float Loudness, APawn* NoiseInstigator, const FVector& Location, float MaxRange, FName Tag)
+{
+	// AI only runs on the server
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	++NumRawEvents;
+	INC_DWORD_STAT(STAT_NoiseRaw);
+
+	const float MergeRadiusSquared = FMath::Square(CVarNoiseMergeRadius.GetValueOnGameThread());
+
+	// merge into a pending noise from the same instigator if it's close enough
+	for (FPendingNoise& Pending : PendingNoises)
+	{
+		if (Pending.Instigator.Get() != NoiseInstigator || Pending.Tag != Tag || FVector::DistSquared(Pending.Location, Location) > MergeRadiusSquared)
+		{
+			continue;
+		}
+
+		if (Loudness > Pending.Loudness)
+		{
+			Pending.Loudness = Loudness;
+			Pending.Location = Location;
+		}
+
+		Pending.MaxRange = FMath::Max(Pending.MaxRange, MaxRange);
+		return;
+	}
+
+	FPendingNoise& Pending = PendingNoises.AddDefaulted_GetRef();
+	Pending.Location = Location;
+	Pending.Loudness = Loudness;
+	Pending.MaxRange = MaxRange;
+	Pending.Tag = Tag;
+	Pending.Instigator = NoiseInstigator;
+	Pending.StartTime = GetWorld()->GetTimeSeconds();
+}
+
+void UShooterNoiseSubsystem::DumpMetrics() const
+{
+	const double MergeRatio = NumEmittedEvents > 0 ? double(NumRawEvents) / double(NumEmittedEvents) : 0.0;
+
+	UE_LOG(LogFirstPersonDemo, Log, TEXT("AI noise: %lld raw events, %lld emitted stimuli (%.2f raw per stimulus), %d pending"), NumRawEvents, NumEmittedEvents, MergeRatio, PendingNoises.Num());
+}
+
+void UShooterNoiseSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (PendingNoises.Num() == 0)
+	{
+		return;
+	}
+
+	const double FlushTime = GetWorld()->GetTimeSeconds() - CVarNoiseMergeWindow.GetValueOnGameThread();
+
+	for (int32 i = 0; i < PendingNoises.Num(); )
+	{
+		if (PendingNoises[i].StartTime > FlushTime)
+		{
+			++i;
+			continue;
+		}
+
+		EmitNoise(PendingNoises[i]);
+		PendingNoises.RemoveAtSwap(i, 1, EAllowShrinking::No);
+	}
+
+	SET_DWORD_STAT(STAT_NoisePending, PendingNoises.Num());
+}
+
+TStatId UShooterNoiseSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterNoiseSubsystem, STATGROUP_Tickables);
+}
+
+bool UShooterNoiseSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterNoiseSubsystem::Deinitialize()
+{
+	PendingNoises.Empty();
+
+	SET_DWORD_STAT(STAT_NoisePending, 0);
+
+	Super::Deinitialize();
+}
+
+void UShooterNoiseSubsystem::EmitNoise(const FPendingNoise& Noise)
+{
+	++NumEmittedEvents;
+	INC_DWORD_STAT(STAT_NoiseEmitted);
+
+	UAISense_Hearing::ReportNoiseEvent(this, Noise.Location, Noise.Loudness, Noise.Instigator.Get(), Noise.MaxRange, Noise.Tag);
+}
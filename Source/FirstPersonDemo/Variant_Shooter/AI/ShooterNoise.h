@@ -0,0 +1,87 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterNoise.generated.h"
+
+class APawn;
+
+/**
+ *  Coalesces AI noise events before they reach the perception system
+ *  Noises from the same instigator with the same tag that land within a short window and radius are merged into a single stimulus
+ *  The merged stimulus keeps the loudest location, loudness and range of the noises it absorbed
+ *  Merged noises are reported to AI perception once their window closes, at most once per frame
+ *  Only runs on the server, since that's where AI lives
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UShooterNoiseSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** A noise waiting for its merge window to close */
+	struct FPendingNoise
+	{
+		/** Location of the loudest noise merged so far */
+		FVector Location = FVector::ZeroVector;
+
+		/** Loudest noise merged so far */
+		float Loudness = 0.0f;
+
+		/** Largest max range merged so far */
+		float MaxRange = 0.0f;
+
+		/** Noise tag. Only noises with the same tag are merged */
+		FName Tag;
+
+		/** Pawn that caused the noise */
+		TWeakObjectPtr<APawn> Instigator;
+
+		/** Time the first noise in this group was reported */
+		double StartTime = 0.0;
+	};
+
+	/** Noises waiting to be reported */
+	TArray<FPendingNoise> PendingNoises;
+
+	/** Total noises reported to this subsystem */
+	int64 NumRawEvents = 0;
+
+	/** Total stimuli passed on to AI perception */
+	int64 NumEmittedEvents = 0;
+
+public:
+
+	/** Reports a noise through the world's noise subsystem, or straight to the noise maker if there's none */
+	static void ReportNoise(AActor* NoiseMaker, float Loudness, APawn* NoiseInstigator, const FVector& Location, float MaxRange, FName Tag);
+
+	/** Queues a noise, merging it with a pending one from the same instigator if it's close enough */
+	void QueueNoise(float Loudness, APawn* NoiseInstigator, const FVector& Location, float MaxRange, FName Tag);
+
+	/** Returns the total number of noises reported */
+	int64 GetNumRawEvents() const { return NumRawEvents; }
+
+	/** Returns the total number of stimuli passed on to AI perception */
+	int64 GetNumEmittedEvents() const { return NumEmittedEvents; }
+
+	/** Logs the raw and emitted event counts */
+	void DumpMetrics() const;
+
+protected:
+
+	/** Reports the noises whose merge window has closed */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat id for this tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Only runs in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Discards the pending noises */
+	virtual void Deinitialize() override;
+
+	/** Passes a merged noise on to AI perception */
+	void EmitNoise(const FPendingNoise& Noise);
+};
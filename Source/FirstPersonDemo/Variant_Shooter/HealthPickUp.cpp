@@ -15,7 +15,8 @@ AHealthPickUp::AHealthPickUp()
 	PrimaryActorTick.bCanEverTick = true;
 
     bReplicates = true;          // ʰȡҪ
-    bAlwaysRelevant = true;      // пͻ˶ܿ/ʾ仯
+    // dormant until someone picks it up or it respawns, so it costs nothing to replicate in between
+    NetDormancy = DORM_Initial;
 
     // Root
     RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
@@ -128,6 +129,9 @@ void AHealthPickUp::OnOverlap(UPrimitiveComponent* OverlappedComponent, AActor*
         ShooterChar->HealToFull();
     }
 
+    // wake up long enough to send the hidden state
+    FlushNetDormancy();
+
     // Լرײ Tick
     SetActorHiddenInGame(true);
     SetActorEnableCollision(false);
@@ -143,6 +147,9 @@ void AHealthPickUp::OnOverlap(UPrimitiveComponent* OverlappedComponent, AActor*
 
 void AHealthPickUp::RespawnPickup()
 {
+    // wake up long enough to send the visible state
+    FlushNetDormancy();
+
     // ȡ
     SetActorHiddenInGame(false);
     SetActorEnableCollision(true);
@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterBenchmarkShooter.h"
+#include "ShooterWeapon.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+AShooterBenchmarkShooter::AShooterBenchmarkShooter()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = Root = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void AShooterBenchmarkShooter::StartShooting(TSubclassOf<AShooterWeapon> WeaponClass, AActor* InTarget, float ShotsPerSecond)
+{
+	Target = InTarget;
+
+	if (!Weapon && WeaponClass)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SpawnParams.Instigator = this;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		Weapon = GetWorld()->SpawnActor<AShooterWeapon>(WeaponClass, GetActorTransform(), SpawnParams);
+	}
+
+	if (Weapon && ShotsPerSecond > 0.0f)
+	{
+		// stagger the first shot so every shooter doesn't fire on the same frame
+		const float Interval = 1.0f / ShotsPerSecond;
+		GetWorld()->GetTimerManager().SetTimer(TriggerTimer, this, &AShooterBenchmarkShooter::PullTrigger, Interval, true, FMath::FRandRange(0.0f, Interval));
+	}
+}
+
+void AShooterBenchmarkShooter::StopShooting()
+{
+	GetWorld()->GetTimerManager().ClearTimer(TriggerTimer);
+
+	if (Weapon)
+	{
+		Weapon->StopFiring();
+	}
+}
+
+void AShooterBenchmarkShooter::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	GetWorld()->GetTimerManager().ClearTimer(TriggerTimer);
+}
+
+void AShooterBenchmarkShooter::PullTrigger()
+{
+	// a quick press and release fires a single shot
+	Weapon->StartFiring();
+	Weapon->StopFiring();
+}
+
+void AShooterBenchmarkShooter::AttachWeaponMeshes(AShooterWeapon* InWeapon)
+{
+	InWeapon->AttachToComponent(Root, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+}
+
+FVector AShooterBenchmarkShooter::GetWeaponTargetLocation()
+{
+	if (Target.IsValid())
+	{
+		return Target->GetActorLocation();
+	}
+
+	return GetActorLocation() + GetActorForwardVector() * 10000.0f;
+}
+
+void AShooterBenchmarkShooter::GetWeaponAimView(FVector& OutViewLocation, FRotator& OutViewRotation)
+{
+	OutViewLocation = GetActorLocation();
+	OutViewRotation = (GetWeaponTargetLocation() - OutViewLocation).Rotation();
+}
@@ -0,0 +1,93 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Pawn.h"
+#include "ShooterWeaponHolder.h"
+#include "ShooterBenchmarkShooter.generated.h"
+
+class USceneComponent;
+class AShooterWeapon;
+
+/**
+ *  Minimal weapon holder used by the projectile benchmark
+ *  Holds a single weapon and pulls the trigger at a fixed rate towards a target
+ *  Has no mesh, animation, HUD or input so only the weapon and projectile costs show up in the measurements
+ */
+UCLASS(NotPlaceable)
+class FIRSTPERSONDEMO_API AShooterBenchmarkShooter : public APawn, public IShooterWeaponHolder
+{
+	GENERATED_BODY()
+
+	/** Root component the weapon attaches to */
+	UPROPERTY(VisibleAnywhere, Category="Components")
+	USceneComponent* Root;
+
+protected:
+
+	/** Weapon fired by this shooter */
+	UPROPERTY()
+	TObjectPtr<AShooterWeapon> Weapon;
+
+	/** Actor the shots are aimed at */
+	TWeakObjectPtr<AActor> Target;
+
+	/** Timer that pulls the trigger */
+	FTimerHandle TriggerTimer;
+
+public:
+
+	/** Constructor */
+	AShooterBenchmarkShooter();
+
+	/** Spawns the weapon and starts pulling the trigger at the given rate */
+	void StartShooting(TSubclassOf<AShooterWeapon> WeaponClass, AActor* InTarget, float ShotsPerSecond);
+
+	/** Stops pulling the trigger */
+	void StopShooting();
+
+protected:
+
+	/** Gameplay cleanup */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+	/** Fires a single shot. The weapon still enforces its own refire rate */
+	void PullTrigger();
+
+public:
+
+	//~Begin IShooterWeaponHolder interface
+
+	/** Attaches the weapon to the root */
+	virtual void AttachWeaponMeshes(AShooterWeapon* InWeapon) override;
+
+	/** Not used by the benchmark */
+	virtual void PlayFiringMontage(UAnimMontage* Montage) override {}
+
+	/** Not used by the benchmark */
+	virtual void AddWeaponRecoil(float Recoil) override {}
+
+	/** Not used by the benchmark */
+	virtual void UpdateWeaponHUD(int32 CurrentAmmo, int32 MagazineSize) override {}
+
+	/** Aims at the target, or straight ahead if there's none */
+	virtual FVector GetWeaponTargetLocation() override;
+
+	/** Aims from the shooter's location towards the target */
+	virtual void GetWeaponAimView(FVector& OutViewLocation, FRotator& OutViewRotation) override;
+
+	/** Not used by the benchmark */
+	virtual void AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override {}
+
+	/** Not used by the benchmark */
+	virtual void OnWeaponActivated(AShooterWeapon* InWeapon) override {}
+
+	/** Not used by the benchmark */
+	virtual void OnWeaponDeactivated(AShooterWeapon* InWeapon) override {}
+
+	/** Not used by the benchmark */
+	virtual void OnSemiWeaponRefire() override {}
+
+	//~End IShooterWeaponHolder interface
+};
@@ -13,10 +13,88 @@
 #include "Camera/CameraComponent.h"
 #include "TimerManager.h"
 #include "ShooterGameMode.h"
+#include "ShooterPlayerController.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Engine/DamageEvents.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+#include "ShooterLagCompensation.h"
+#include "Animation/AnimInstance.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "FirstPersonDemo.h"
+#include "Components/CapsuleComponent.h"
+#include "ShooterCharacterMovementComponent.h"
+#include "ShooterDamage.h"
+#include "UObject/ObjectSaveContext.h"
+
+DECLARE_STATS_GROUP(TEXT("ShooterCharacter"), STATGROUP_ShooterCharacter, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Anim Switch"), STAT_WeaponAnimSwitch, STATGROUP_ShooterCharacter);
+DECLARE_CYCLE_STAT(TEXT("Respawn"), STAT_Respawn, STATGROUP_ShooterCharacter);
+
+static TAutoConsoleVariable<bool> CVarInPlaceRespawn(
+	TEXT("Shooter.InPlaceRespawn"),
+	true,
+	TEXT("If true, dead characters are reset and moved to a player start instead of being destroyed and spawned again"));
+
+static TAutoConsoleVariable<bool> CVarWeaponAnimLayers(
+	TEXT("Shooter.WeaponAnimLayers"),
+	true,
+	TEXT("If true, weapon anim classes are linked as anim layers when the character's anim instance supports it, instead of replacing the anim instance"));
+
+static TAutoConsoleVariable<float> CVarAimSendRate(
+	TEXT("Shooter.AimSendRate"),
+	30.0f,
+	TEXT("Max aim updates per second a client sends to the server. 0 sends every frame the aim changes"));
+
+static TAutoConsoleVariable<float> CVarAimSendThreshold(
+	TEXT("Shooter.AimSendThreshold"),
+	0.2f,
+	TEXT("Degrees the aim has to move before a client sends another aim update"));
+
+static TAutoConsoleVariable<float> CVarAimKeepAliveInterval(
+	TEXT("Shooter.AimKeepAliveInterval"),
+	0.25f,
+	TEXT("Seconds after which a client resends its aim even if it hasn't moved, so a dropped update can't leave the server with a stale aim. 0 disables it"));
+
+static TAutoConsoleVariable<float> CVarAimInterpSpeed(
+	TEXT("Shooter.AimInterpSpeed"),
+	25.0f,
+	TEXT("Speed the server interpolates remote players' aim towards their latest update. 0 snaps to it"));
+
+static FAutoConsoleCommandWithWorld GAimNetStatsCommand(
+	TEXT("Shooter.AimNetStats"),
+	TEXT("Logs the aim update payload bytes per second received from every remote player. Server only"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+		{
+			const AShooterPlayerController* PC = Cast<AShooterPlayerController>(It->Get());
+
+			if (PC && !PC->IsLocalController())
+			{
+				UE_LOG(LogFirstPersonDemo, Log, TEXT("%s: %d aim bytes/s"), *PC->GetName(), PC->GetAimBytesPerSecond());
+			}
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWeaponSwitchBenchmarkCommand(
+	TEXT("Shooter.BenchmarkWeaponSwitch"),
+	TEXT("Times weapon anim switches on the local player character, with and without linked anim layers. Usage: Shooter.BenchmarkWeaponSwitch [NumSwitches]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumSwitches = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
 
-AShooterCharacter::AShooterCharacter()
+		if (AShooterCharacter* Character = Cast<AShooterCharacter>(UGameplayStatics::GetPlayerPawn(World, 0)))
+		{
+			Character->BenchmarkWeaponSwitch(NumSwitches);
+		}
+	}));
+
+AShooterCharacter::AShooterCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UShooterCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// enable replication
 	bReplicates = true;
@@ -32,10 +110,31 @@ void AShooterCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// remember the body setup so an in place respawn can undo the death ragdoll
+	MeshRelativeTransform = GetMesh()->GetRelativeTransform();
+	MeshCollisionProfile = GetMesh()->GetCollisionProfileName();
+	CapsuleCollisionProfile = GetCapsuleComponent()->GetCollisionProfileName();
+
+	// the movement component switches to the berserk speed on its own, from the match clock
+	GetShooterMovement()->SetWalkSpeeds(NormalWalkSpeed, BerserkWalkSpeed);
+
 	// ֻڷʼ HPͻͨƻ
 	if (HasAuthority())
 	{
 		CurrentHP = MaxHP;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentHP, this);
+
+		// dedicated servers never render the first person mesh and place shots with the analytic muzzle, so skip its animation
+		if (GetNetMode() == NM_DedicatedServer && bHasBakedWeaponSocket)
+		{
+			GetFirstPersonMesh()->SetComponentTickEnabled(false);
+		}
+
+		// record our hitbox history so hitscan shots can be lag compensated
+		if (UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
 	}
 
 	// õԼʱˢһ UIػ
@@ -48,6 +147,12 @@ void AShooterCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 	// clear the re spawn timer
 	GetWorld()->GetTimerManager().ClearTimer(RespawnTimer);
+
+	// stop recording our hitbox history
+	if (UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
 }
 
 void AShooterCharacter::Tick(float DeltaSeconds)
@@ -57,17 +162,93 @@ void AShooterCharacter::Tick(float DeltaSeconds)
 	// ֻбؿƵһݽɫӽ
 	if (IsLocallyControlled())
 	{
-		if (AController* C = GetController())
+		// the server aims from its own camera, so only remote clients send their aim
+		if (!HasAuthority())
 		{
-			ServerSetAimRotation(C->GetControlRotation());
+			SendAimRotation();
 		}
+
+	} else if (HasAuthority() && bHasTargetAim)
+	{
+		// smooth the aim between the rate limited updates
+		AimRotation = FMath::RInterpTo(AimRotation, TargetAimRotation, DeltaSeconds, CVarAimInterpSpeed.GetValueOnGameThread());
 	}
+
+	// mirror the predicted berserk state for Blueprint
+	bIsBerserkTime = GetShooterMovement()->IsBerserk();
+}
+
+UShooterCharacterMovementComponent* AShooterCharacter::GetShooterMovement() const
+{
+	return CastChecked<UShooterCharacterMovementComponent>(GetCharacterMovement());
 }
 
-void AShooterCharacter::ServerSetAimRotation_Implementation(const FRotator& NewAimRotation)
+void AShooterCharacter::SendAimRotation()
+{
+	AController* C = GetController();
+
+	if (!C)
+	{
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const float SendRate = CVarAimSendRate.GetValueOnGameThread();
+
+	// don't send faster than the configured rate
+	if (SendRate > 0.0f && Now - LastAimSendTime < 1.0 / SendRate)
+	{
+		return;
+	}
+
+	// only send when the aim moved further than the threshold from what the server already has
+	const uint32 PackedAim = PackAimRotation(C->GetControlRotation());
+	const FRotator QuantizedAim = UnpackAimRotation(PackedAim);
+
+	const bool bAimChanged = LastAimSendTime <= 0.0 || !QuantizedAim.Equals(LastSentAimRotation, CVarAimSendThreshold.GetValueOnGameThread());
+
+	// updates are unreliable, so resend the settled aim every so often in case the last one was dropped
+	const float KeepAliveInterval = CVarAimKeepAliveInterval.GetValueOnGameThread();
+	const bool bKeepAlive = KeepAliveInterval > 0.0f && Now - LastAimSendTime >= KeepAliveInterval;
+
+	if (!bAimChanged && !bKeepAlive)
+	{
+		return;
+	}
+
+	LastSentAimRotation = QuantizedAim;
+	LastAimSendTime = Now;
+
+	ServerUpdateAim(PackedAim);
+}
+
+uint32 AShooterCharacter::PackAimRotation(const FRotator& Rotation)
+{
+	return (static_cast<uint32>(FRotator::CompressAxisToShort(Rotation.Pitch)) << 16) | FRotator::CompressAxisToShort(Rotation.Yaw);
+}
+
+FRotator AShooterCharacter::UnpackAimRotation(uint32 PackedAim)
+{
+	return FRotator(FRotator::DecompressAxisFromShort(static_cast<uint16>(PackedAim >> 16)), FRotator::DecompressAxisFromShort(static_cast<uint16>(PackedAim & 0xFFFF)), 0.0f);
+}
+
+void AShooterCharacter::ServerUpdateAim_Implementation(uint32 PackedAim)
 {
 	// ֻڷ߷
-	AimRotation = NewAimRotation;
+	TargetAimRotation = UnpackAimRotation(PackedAim);
+
+	// snap to the first update instead of sweeping from the default rotation
+	if (!bHasTargetAim)
+	{
+		AimRotation = TargetAimRotation;
+		bHasTargetAim = true;
+	}
+
+	// count the payload against the sender's connection
+	if (AShooterPlayerController* PC = Cast<AShooterPlayerController>(GetController()))
+	{
+		PC->CountAimBytes(sizeof(PackedAim));
+	}
 }
 
 void AShooterCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -88,23 +269,6 @@ void AShooterCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 
 }
 
-// лƶٶ
-void AShooterCharacter::UpdateBerserkMovement()
-{
-	UCharacterMovementComponent* MoveComp = GetCharacterMovement();
-	if (!MoveComp) return;
-
-	// ע⣺õǴӸ̳ bIsBerserkTime
-	MoveComp->MaxWalkSpeed = bIsBerserkTime ? BerserkWalkSpeed : NormalWalkSpeed;
-}
-
-// ÿ״̬
-void AShooterCharacter::ServerSetBerserk_Implementation(bool bNewBerserk)
-{
-	bIsBerserkTime = bNewBerserk;
-	UpdateBerserkMovement();
-}
-
 float AShooterCharacter::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
 	// Ҫڿͻ˳ԱӦ˺ת˺Ӧɷϵ projectile/Ϸ߼ִУ
@@ -120,22 +284,41 @@ float AShooterCharacter::TakeDamage(float Damage, struct FDamageEvent const& Dam
 		return 0.0f;
 	}
 
-	// ¼˺Դ˺ / ɱʱ EventInstigator Ϊ nullptr
-	LastHitInstigator = EventInstigator;
+	// collect the hit, it gets applied together with the rest of this frame's damage
+	if (DamageAccumulator.AddDamage(Damage, EventInstigator, CurrentHP, GetWorld()->GetTimeSeconds()))
+	{
+		UShooterDamageSubsystem::QueueTarget(this);
+	}
+
+	return Damage;
+}
+
+void AShooterCharacter::ResolvePendingDamage()
+{
+	AController* KillingInstigator = nullptr;
+	const float Damage = DamageAccumulator.ConsumePendingDamage(GetWorld()->GetTimeSeconds(), KillingInstigator);
+
+	// we may have died or respawned since the damage was queued
+	if (CurrentHP <= 0.0f || Damage <= 0.0f)
+	{
+		return;
+	}
 
 	// Reduce HP (server authoritative)
 	CurrentHP -= Damage;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentHP, this);
 
 	// Have we depleted HP?
 	if (CurrentHP <= 0.0f)
 	{
+		// ¼˺Դ˺ / ɱʱ EventInstigator Ϊ nullptr
+		LastHitInstigator = KillingInstigator;
+
 		Die();
 	}
 
 	// update the HUD (server-side broadcast/local effects)
 	OnDamaged.Broadcast(FMath::Max(0.0f, CurrentHP / MaxHP));
-
-	return Damage;
 }
 
 void AShooterCharacter::OnRep_CurrentHP()
@@ -153,7 +336,27 @@ void AShooterCharacter::DoStartFiring()
 	// ͻʼ
 	if (!HasAuthority())
 	{
-		ServerStartFiring();
+		// the other characters we see were replicated about half a round trip ago
+		float ClientTimeStamp = GetWorld()->GetTimeSeconds();
+
+		if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+		{
+			ClientTimeStamp = GameState->GetServerWorldTimeSeconds();
+
+			if (const APlayerState* PS = GetPlayerState())
+			{
+				ClientTimeStamp -= PS->GetPingInMilliseconds() * 0.0005f;
+			}
+		}
+
+		ServerStartFiring(ClientTimeStamp, CurrentWeapon ? CurrentWeapon->GetNextShotId() : 0, CurrentWeapon ? CurrentWeapon->GetBulletCount() : 0);
+
+		// predict the shots locally so we don't wait a round trip to see them
+		if (CurrentWeapon)
+		{
+			CurrentWeapon->StartFiring();
+		}
+
 		return;
 	}
 	// fire the current weapon
@@ -169,6 +372,13 @@ void AShooterCharacter::DoStopFiring()
 	if (!HasAuthority())
 	{
 		ServerStopFiring();
+
+		// stop predicting shots
+		if (CurrentWeapon)
+		{
+			CurrentWeapon->StopFiring();
+		}
+
 		return;
 	}
 	// stop firing the current weapon
@@ -179,16 +389,39 @@ void AShooterCharacter::DoStopFiring()
 }
 
 // RPCʵ
-void AShooterCharacter::ServerStartFiring_Implementation()
+void AShooterCharacter::ServerStartFiring_Implementation(float ClientTimeStamp, uint16 FirstShotId, int32 PredictedBullets)
 {
 	// ټһ飬ֹͻҷ
 	if (bInputLocked)
 	{
+		// let the client remove the shots it already predicted
+		if (CurrentWeapon)
+		{
+			CurrentWeapon->RejectShots(FirstShotId);
+		}
+
 		return;
 	}
 
 	if (CurrentWeapon)
 	{
+		// count shots from the same id the client used for its predictions, and fix its ammo if it drifted
+		// the server owns the counter, so ids it didn't expect get the shots refused instead
+		if (!CurrentWeapon->SyncShotPrediction(FirstShotId, PredictedBullets))
+		{
+			CurrentWeapon->RejectShots(FirstShotId);
+			return;
+		}
+
+		// work out how far to rewind this client's shots, within the allowed window
+		float RewindOffset = 0.0f;
+
+		if (const UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>())
+		{
+			RewindOffset = FMath::Clamp(GetWorld()->GetTimeSeconds() - ClientTimeStamp, 0.0f, LagCompensation->GetMaxRewindTime());
+		}
+
+		CurrentWeapon->SetLagCompensationOffset(RewindOffset);
 		CurrentWeapon->StartFiring();
 	}
 }
@@ -225,6 +458,7 @@ void AShooterCharacter::DoSwitchWeapon()
 
 		// set the new weapon as current
 		CurrentWeapon = OwnedWeapons[WeaponIndex];
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentWeapon, this);
 
 		// activate the new weapon
 		CurrentWeapon->ActivateWeapon();
@@ -283,7 +517,7 @@ FVector AShooterCharacter::GetWeaponTargetLocation()
     {
         // ϡԶҡһݣÿͻͬ AimRotation
         Start = GetPawnViewLocation();      // ɫ۾λãǿɿ
-        const FVector AimDir = AimRotation.Vector();
+        const FVector AimDir = GetShotAimRotation().Vector();
 
         End = Start + AimDir * MaxAimDistance;
     }
@@ -294,6 +528,37 @@ FVector AShooterCharacter::GetWeaponTargetLocation()
     return OutHit.bBlockingHit ? OutHit.ImpactPoint : OutHit.TraceEnd;
 }
 
+void AShooterCharacter::GetWeaponAimView(FVector& OutViewLocation, FRotator& OutViewRotation)
+{
+	if (IsLocallyControlled())
+	{
+		// the local copy aims from the camera, like GetWeaponTargetLocation
+		OutViewLocation = GetFirstPersonCameraComponent()->GetComponentLocation();
+		OutViewRotation = GetFirstPersonCameraComponent()->GetComponentRotation();
+
+	} else {
+
+		// remote players aim from their eyes along the rotation they sent us, so nothing here depends on animation
+		OutViewLocation = GetPawnViewLocation();
+		OutViewRotation = GetShotAimRotation();
+	}
+}
+
+bool AShooterCharacter::GetBakedWeaponSocket(FTransform& OutSocketTransform) const
+{
+	OutSocketTransform = BakedWeaponSocket;
+	return bHasBakedWeaponSocket;
+}
+
+#if WITH_EDITOR
+void AShooterCharacter::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	bHasBakedWeaponSocket = BakeWeaponSocket(this, GetFirstPersonMesh(), FirstPersonWeaponSocket, BakedWeaponSocket);
+}
+#endif
+
 void AShooterCharacter::AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass)
 {
 	// NOTE: ֻӦڷϵã ServerAddWeaponClass  GameMode ȣ
@@ -314,7 +579,7 @@ void AShooterCharacter::AddWeaponClass(const TSubclassOf<AShooterWeapon>& Weapon
 		if (AddedWeapon)
 		{
 			// add the weapon to the owned list
-			OwnedWeapons.Add(AddedWeapon);
+			AddOwnedWeapon(AddedWeapon);
 
 			// if we have an existing weapon, deactivate it
 			if (CurrentWeapon)
@@ -324,6 +589,7 @@ void AShooterCharacter::AddWeaponClass(const TSubclassOf<AShooterWeapon>& Weapon
 
 			// switch to the new weapon
 			CurrentWeapon = AddedWeapon;
+			MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentWeapon, this);
 			CurrentWeapon->ActivateWeapon();
 		}
 	}
@@ -340,9 +606,95 @@ void AShooterCharacter::OnWeaponActivated(AShooterWeapon* Weapon)
 	// update the bullet counter
 	OnBulletCountUpdated.Broadcast(Weapon->GetMagazineSize(), Weapon->GetBulletCount());
 
-	// set the character mesh AnimInstances
-	GetFirstPersonMesh()->SetAnimInstanceClass(Weapon->GetFirstPersonAnimInstanceClass());
-	GetMesh()->SetAnimInstanceClass(Weapon->GetThirdPersonAnimInstanceClass());
+	SCOPE_CYCLE_COUNTER(STAT_WeaponAnimSwitch);
+
+	// link the weapon animations into the character mesh AnimInstances
+	ApplyWeaponAnimClass(GetFirstPersonMesh(), Weapon->GetFirstPersonAnimInstanceClass(), CVarWeaponAnimLayers.GetValueOnGameThread());
+	ApplyWeaponAnimClass(GetMesh(), Weapon->GetThirdPersonAnimInstanceClass(), CVarWeaponAnimLayers.GetValueOnGameThread());
+}
+
+void AShooterCharacter::ApplyWeaponAnimClass(USkeletalMeshComponent* TargetMesh, TSubclassOf<UAnimInstance> WeaponAnimClass, bool bAllowLinking)
+{
+	if (!TargetMesh || !WeaponAnimClass)
+	{
+		return;
+	}
+
+	const UAnimInstance* BaseInstance = TargetMesh->GetAnimInstance();
+
+	// nothing to do if the weapon class is already running as the main instance
+	if (BaseInstance && BaseInstance->GetClass() == WeaponAnimClass)
+	{
+		return;
+	}
+
+	if (bAllowLinking && BaseInstance && CanLinkAnimLayers(BaseInstance->GetClass(), WeaponAnimClass))
+	{
+		// replaces the layers of the previous weapon. The base instance keeps its state
+		TargetMesh->LinkAnimClassLayers(WeaponAnimClass);
+		return;
+	}
+
+	// the weapon class can't be linked into the current instance, so swap the whole instance
+	TargetMesh->SetAnimInstanceClass(WeaponAnimClass);
+}
+
+bool AShooterCharacter::CanLinkAnimLayers(const UClass* BaseClass, const UClass* LayerClass)
+{
+	for (const UClass* Class = LayerClass; Class; Class = Class->GetSuperClass())
+	{
+		for (const FImplementedInterface& Interface : Class->Interfaces)
+		{
+			if (Interface.Class && BaseClass->ImplementsInterface(Interface.Class))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void AShooterCharacter::BenchmarkWeaponSwitch(int32 NumSwitches)
+{
+	if (OwnedWeapons.Num() < 2 || NumSwitches < 1)
+	{
+		UE_LOG(LogFirstPersonDemo, Warning, TEXT("Weapon switch benchmark needs at least two owned weapons"));
+		return;
+	}
+
+	auto TimeSwitches = [this, NumSwitches](bool bAllowLinking)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 i = 0; i < NumSwitches; ++i)
+		{
+			const AShooterWeapon* Weapon = OwnedWeapons[i % 2];
+
+			ApplyWeaponAnimClass(GetFirstPersonMesh(), Weapon->GetFirstPersonAnimInstanceClass(), bAllowLinking);
+			ApplyWeaponAnimClass(GetMesh(), Weapon->GetThirdPersonAnimInstanceClass(), bAllowLinking);
+		}
+
+		return (FPlatformTime::Seconds() - StartTime) * 1000.0 / NumSwitches;
+	};
+
+	// swapping replaces the base instances, so remember them to restore afterwards
+	const TSubclassOf<UAnimInstance> FirstPersonBaseClass = GetFirstPersonMesh()->GetAnimClass();
+	const TSubclassOf<UAnimInstance> ThirdPersonBaseClass = GetMesh()->GetAnimClass();
+
+	const double LinkTime = TimeSwitches(true);
+	const double SwapTime = TimeSwitches(false);
+
+	UE_LOG(LogFirstPersonDemo, Log, TEXT("Weapon switch benchmark: %d switches, anim instance swap %.3fms, linked layers %.3fms"), NumSwitches, SwapTime, LinkTime);
+
+	GetFirstPersonMesh()->SetAnimInstanceClass(FirstPersonBaseClass);
+	GetMesh()->SetAnimInstanceClass(ThirdPersonBaseClass);
+
+	// put the equipped weapon's animations back
+	if (CurrentWeapon)
+	{
+		OnWeaponActivated(CurrentWeapon);
+	}
 }
 
 void AShooterCharacter::OnWeaponDeactivated(AShooterWeapon* Weapon)
@@ -357,18 +709,56 @@ void AShooterCharacter::OnSemiWeaponRefire()
 
 AShooterWeapon* AShooterCharacter::FindWeaponOfType(TSubclassOf<AShooterWeapon> WeaponClass) const
 {
-	// check each owned weapon
-	for (AShooterWeapon* Weapon : OwnedWeapons)
+	AShooterWeapon* const* FoundWeapon = WeaponsByClass.Find(WeaponClass);
+	return FoundWeapon ? *FoundWeapon : nullptr;
+}
+
+void AShooterCharacter::AddOwnedWeapon(AShooterWeapon* Weapon)
+{
+	OwnedWeapons.Add(Weapon);
+	WeaponsByClass.Add(Weapon->GetClass(), Weapon);
+}
+
+void AShooterCharacter::RestoreWeapons(const TArray<TObjectPtr<AShooterWeapon>>& Weapons, int32 EquippedIndex)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	for (AShooterWeapon* Weapon : Weapons)
 	{
-		if (Weapon->IsA(WeaponClass))
+		// skip weapons that didn't make it or that we already picked up again
+		if (!IsValid(Weapon) || FindWeaponOfType(Weapon->GetClass()))
 		{
-			return Weapon;
+			continue;
 		}
+
+		// reattach the weapon to us. It stays hidden until it's activated
+		Weapon->SetWeaponHolder(this);
+
+		AddOwnedWeapon(Weapon);
 	}
 
-	// weapon not found
-	return nullptr;
+	// equip the weapon we were holding when we died, or the first one we have
+	AShooterWeapon* EquippedWeapon = Weapons.IsValidIndex(EquippedIndex) ? Weapons[EquippedIndex] : nullptr;
+
+	if (!IsValid(EquippedWeapon) || !OwnedWeapons.Contains(EquippedWeapon))
+	{
+		EquippedWeapon = OwnedWeapons.Num() > 0 ? OwnedWeapons[0] : nullptr;
+	}
 
+	if (EquippedWeapon && EquippedWeapon != CurrentWeapon)
+	{
+		if (CurrentWeapon)
+		{
+			CurrentWeapon->DeactivateWeapon();
+		}
+
+		CurrentWeapon = EquippedWeapon;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentWeapon, this);
+		CurrentWeapon->ActivateWeapon();
+	}
 }
 
 void AShooterCharacter::Die()
@@ -429,8 +819,129 @@ void AShooterCharacter::OnRespawn()
 	{
 		return;
 	}
+	SCOPE_CYCLE_COUNTER(STAT_Respawn);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// reuse this character if we can, so clients keep its actor channel and nothing has to be rebuilt
+	if (CVarInPlaceRespawn.GetValueOnGameThread() && RespawnInPlace())
+	{
+		UE_LOG(LogFirstPersonDemo, Verbose, TEXT("%s respawned in place in %.3f ms"), *GetName(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		return;
+	}
+
+	// hand our weapons to the controller so the next character can pick them back up instead of spawning new ones
+	if (AShooterPlayerController* PC = Cast<AShooterPlayerController>(GetController()))
+	{
+		PC->StoreWeapons(OwnedWeapons, CurrentWeapon);
+
+		OwnedWeapons.Reset();
+		WeaponsByClass.Reset();
+		CurrentWeapon = nullptr;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentWeapon, this);
+	}
+
 	// destroy the character to force the PC to respawn (server-side)
 	Destroy();
+
+	UE_LOG(LogFirstPersonDemo, Verbose, TEXT("%s respawned as a new character in %.3f ms"), *GetName(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+bool AShooterCharacter::RespawnInPlace()
+{
+	APlayerController* PC = Cast<APlayerController>(GetController());
+	AGameModeBase* GM = GetWorld()->GetAuthGameMode();
+
+	if (!PC || !GM)
+	{
+		return false;
+	}
+
+	AActor* StartSpot = GM->FindPlayerStart(PC);
+
+	if (!StartSpot)
+	{
+		return false;
+	}
+
+	// restore collision first so the teleport can check the spot is free
+	ResetRagdoll();
+
+	const FRotator SpawnRotation(0.0f, StartSpot->GetActorRotation().Yaw, 0.0f);
+
+	if (!TeleportTo(StartSpot->GetActorLocation(), SpawnRotation))
+	{
+		return false;
+	}
+
+	// face the same way as the player start
+	PC->SetControlRotation(SpawnRotation);
+	PC->ClientSetRotation(SpawnRotation, true);
+
+	// reset the health and death state
+	CurrentHP = MaxHP;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentHP, this);
+	LastHitInstigator = nullptr;
+	DamageAccumulator.Reset();
+
+	// snap to the first aim update from the new spot instead of sweeping from where we died
+	bHasTargetAim = false;
+
+	// drop the hitbox history so rewound shots don't sweep the capsule from where we died
+	if (UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+		LagCompensation->RegisterCharacter(this);
+	}
+
+	// bring the weapon back out
+	if (IsValid(CurrentWeapon))
+	{
+		CurrentWeapon->ActivateWeapon();
+	}
+
+	MulticastOnRespawn();
+
+	ForceNetUpdate();
+
+	return true;
+}
+
+void AShooterCharacter::MulticastOnRespawn_Implementation()
+{
+	ResetRagdoll();
+
+	// get moving again
+	GetCharacterMovement()->SetDefaultMovementMode();
+
+	// re-enable controls
+	EnableInput(nullptr);
+
+	// refresh the UI
+	OnDamaged.Broadcast(1.0f);
+
+	if (IsValid(CurrentWeapon))
+	{
+		OnBulletCountUpdated.Broadcast(CurrentWeapon->GetMagazineSize(), CurrentWeapon->GetBulletCount());
+	}
+
+	// let Blueprint undo its death effects
+	BP_OnRespawn();
+}
+
+void AShooterCharacter::ResetRagdoll()
+{
+	USkeletalMeshComponent* BodyMesh = GetMesh();
+
+	// stop simulating and snap the mesh back onto the capsule
+	BodyMesh->SetSimulatePhysics(false);
+	BodyMesh->SetCollisionProfileName(MeshCollisionProfile);
+	BodyMesh->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	BodyMesh->SetRelativeTransform(MeshRelativeTransform);
+
+	// restore the capsule collision
+	GetCapsuleComponent()->SetCollisionProfileName(CapsuleCollisionProfile);
+	SetActorEnableCollision(true);
 }
 
 void AShooterCharacter::Heal(float Amount)
@@ -448,6 +959,7 @@ void AShooterCharacter::Heal(float Amount)
 	}
 
 	CurrentHP = FMath::Clamp(CurrentHP + Amount, 0.0f, MaxHP);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentHP, this);
 
 	// ȹ㲥һΣ± UI
 	OnDamaged.Broadcast(MaxHP > 0.0f ? CurrentHP / MaxHP : 0.0f);
@@ -468,6 +980,7 @@ void AShooterCharacter::HealToFull()
 	}
 
 	CurrentHP = MaxHP;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, CurrentHP, this);
 
 	// Ѫֱӹ㲥 1.0
 	OnDamaged.Broadcast(1.0f);
@@ -477,6 +990,10 @@ void AShooterCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShooterCharacter, CurrentHP);
-	DOREPLIFETIME(AShooterCharacter, TeamByte);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterCharacter, CurrentHP, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterCharacter, TeamByte, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterCharacter, CurrentWeapon, Params);
 }
\ No newline at end of file
@@ -5,12 +5,16 @@
 #include "CoreMinimal.h"
 #include "FirstPersonDemoCharacter.h"
 #include "ShooterWeaponHolder.h"
+#include "ShooterDamage.h"
 #include "ShooterCharacter.generated.h"
 
 class AShooterWeapon;
+class UAnimInstance;
+class USkeletalMeshComponent;
 class UInputAction;
 class UInputComponent;
 class UPawnNoiseEmitterComponent;
+class UShooterCharacterMovementComponent;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FBulletCountUpdatedDelegate, int32, MagazineSize, int32, Bullets);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FDamagedDelegate, float, LifePercent);
@@ -21,7 +25,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FDamagedDelegate, float, LifePercent
  *  Manages health and death
  */
 UCLASS(abstract)
-class FIRSTPERSONDEMO_API AShooterCharacter : public AFirstPersonDemoCharacter, public IShooterWeaponHolder
+class FIRSTPERSONDEMO_API AShooterCharacter : public AFirstPersonDemoCharacter, public IShooterWeaponHolder, public IShooterDamageTarget
 {
 	GENERATED_BODY()
 	
@@ -53,6 +57,14 @@ protected:
 	UPROPERTY(EditAnywhere, Category ="Weapons")
 	FName ThirdPersonWeaponSocket = FName("HandGrip_R");
 
+	/** First person weapon socket relative to the eye view, in the first person mesh reference pose. Baked when the character is saved */
+	UPROPERTY(VisibleAnywhere, Category ="Weapons")
+	FTransform BakedWeaponSocket;
+
+	/** If true, the weapon socket has been baked */
+	UPROPERTY(VisibleAnywhere, Category ="Weapons")
+	bool bHasBakedWeaponSocket = false;
+
 	/** Max distance to use for aim traces */
 	UPROPERTY(EditAnywhere, Category ="Aim", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
 	float MaxAimDistance = 10000.0f;
@@ -69,10 +81,25 @@ protected:
     UPROPERTY()
     FRotator AimRotation;
 
+	/** Latest aim rotation received from the owning client. Shots are fired along it, while AimRotation interpolates towards it for presentation. Server only */
+	FRotator TargetAimRotation;
+
+	/** If true, the server has received at least one aim update for this character */
+	bool bHasTargetAim = false;
+
+	/** Last aim rotation sent to the server, as the server decoded it. Local only */
+	FRotator LastSentAimRotation;
+
+	/** Time the last aim update was sent. Local only */
+	double LastAimSendTime = 0.0;
+
 	// ¼һ˺ Instigatorɱã
 	UPROPERTY()
 	AController* LastHitInstigator = nullptr;
 
+	/** Damage taken this frame and the recent hit history. Server only */
+	FShooterDamageAccumulator DamageAccumulator;
+
 	// RepNotifyڿͻ˴ UI
 	UFUNCTION()
 	void OnRep_CurrentHP();
@@ -80,7 +107,11 @@ protected:
 	/** List of weapons picked up by the character */
 	TArray<AShooterWeapon*> OwnedWeapons;
 
-	/** Weapon currently equipped and ready to shoot with */
+	/** Owned weapons keyed by class, for quick lookups when picking up weapons */
+	TMap<UClass*, AShooterWeapon*> WeaponsByClass;
+
+	/** Weapon currently equipped and ready to shoot with. Replicated so the owning client can predict its shots */
+	UPROPERTY(Replicated)
 	TObjectPtr<AShooterWeapon> CurrentWeapon;
 
 	UPROPERTY(EditAnywhere, Category ="Destruction", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
@@ -88,6 +119,15 @@ protected:
 
 	FTimerHandle RespawnTimer;
 
+	/** Mesh transform relative to the capsule, restored after the death ragdoll */
+	FTransform MeshRelativeTransform;
+
+	/** Mesh collision profile, restored after the death ragdoll */
+	FName MeshCollisionProfile;
+
+	/** Capsule collision profile, restored on respawn */
+	FName CapsuleCollisionProfile;
+
 public:
 
 	/** Bullet count updated delegate */
@@ -103,7 +143,7 @@ public:
 public:
 
 	/** Constructor */
-	AShooterCharacter();
+	AShooterCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 
@@ -115,11 +155,29 @@ protected:
 	/** Gameplay cleanup */
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
+#if WITH_EDITOR
+	/** Bakes the weapon socket so cooked builds never need to evaluate the first person mesh for it */
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#endif
+
 	/** Set up input action bindings */
 	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
 
-    UFUNCTION(Server, Unreliable)
-    void ServerSetAimRotation(const FRotator& NewAimRotation);
+	/** Sends the aim rotation to the server when it has changed enough or the keepalive is due, at most at the configured rate */
+	void SendAimRotation();
+
+	/** Returns the rotation shots are fired along on the server for a remote player. The last received aim, so shots don't lag the client's crosshair */
+	const FRotator& GetShotAimRotation() const { return bHasTargetAim ? TargetAimRotation : AimRotation; }
+
+	/** Receives a quantized aim rotation from the owning client */
+	UFUNCTION(Server, Unreliable)
+	void ServerUpdateAim(uint32 PackedAim);
+
+	/** Quantizes pitch and yaw to 16 bits each. Roll isn't needed to aim */
+	static uint32 PackAimRotation(const FRotator& Rotation);
+
+	/** Restores a rotation quantized by PackAimRotation */
+	static FRotator UnpackAimRotation(uint32 PackedAim);
 
 public:
 
@@ -152,8 +210,13 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Health")
 	void HealToFull();
 
+	/**
+	 *  Asks the server to start firing. The timestamp is the server time of the world state the client was seeing
+	 *  The first shot id is the id of the first shot the client predicted, so both sides number their shots the same way
+	 *  The predicted bullets are the client's ammo count before that shot, so the server can correct it if it drifted
+	 */
 	UFUNCTION(Server, Reliable)
-	void ServerStartFiring();
+	void ServerStartFiring(float ClientTimeStamp, uint16 FirstShotId, int32 PredictedBullets);
 
 	UFUNCTION(Server, Reliable)
 	void ServerStopFiring();
@@ -161,11 +224,8 @@ public:
 	UFUNCTION(Server, Reliable)
 	void ServerAddWeaponClass(TSubclassOf<AShooterWeapon> WeaponClass);
 
-	UFUNCTION()
-	void UpdateBerserkMovement();
-
-	UFUNCTION(Server, Reliable)
-	void ServerSetBerserk(bool bNewBerserk);
+	/** Returns the movement component cast to its shooter type */
+	UShooterCharacterMovementComponent* GetShooterMovement() const;
 
 public:
 
@@ -186,6 +246,12 @@ public:
 	/** Calculates and returns the aim location for the weapon */
 	virtual FVector GetWeaponTargetLocation() override;
 
+	/** Returns the view the weapon is aimed from */
+	virtual void GetWeaponAimView(FVector& OutViewLocation, FRotator& OutViewRotation) override;
+
+	/** Returns the weapon socket baked from the first person mesh */
+	virtual bool GetBakedWeaponSocket(FTransform& OutSocketTransform) const override;
+
 	/** Gives a weapon of this class to the owner */
 	virtual void AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override;
 
@@ -200,11 +266,46 @@ public:
 
 	//~End IShooterWeaponHolder interface
 
+	//~Begin IShooterDamageTarget interface
+
+	/** Applies all the damage accumulated this frame in one go */
+	virtual void ResolvePendingDamage() override;
+
+	/** Returns true while the character is dead and waiting to respawn */
+	virtual bool IsDead() const override { return CurrentHP <= 0.0f; }
+
+	//~End IShooterDamageTarget interface
+
 protected:
 
-	/** Returns true if the character already owns a weapon of the given class */
+	/** Returns the owned weapon of the given class, if any */
 	AShooterWeapon* FindWeaponOfType(TSubclassOf<AShooterWeapon> WeaponClass) const;
 
+	/** Adds a weapon to the owned lists */
+	void AddOwnedWeapon(AShooterWeapon* Weapon);
+
+	/**
+	 *  Applies a weapon anim class to a mesh
+	 *  If the mesh's anim instance implements one of the anim layer interfaces of the weapon class, the weapon class is linked as layers and the base instance keeps running
+	 *  Otherwise, or if linking is disallowed, the whole anim instance is replaced
+	 */
+	void ApplyWeaponAnimClass(USkeletalMeshComponent* TargetMesh, TSubclassOf<UAnimInstance> WeaponAnimClass, bool bAllowLinking = true);
+
+	/** Returns true if the layer class implements an anim layer interface the base class also implements */
+	static bool CanLinkAnimLayers(const UClass* BaseClass, const UClass* LayerClass);
+
+public:
+
+	/** Switches between the first two owned weapons' anim classes the given number of times, with and without linked layers, and logs the average cost of each */
+	void BenchmarkWeaponSwitch(int32 NumSwitches);
+
+public:
+
+	/** Takes over weapons carried from a previous life and equips the one at the given index. Server only */
+	void RestoreWeapons(const TArray<TObjectPtr<AShooterWeapon>>& Weapons, int32 EquippedIndex);
+
+protected:
+
 	/** Called when this character's HP is depleted */
 	void Die();
 
@@ -216,6 +317,20 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent, Category="Shooter", meta = (DisplayName = "On Death"))
 	void BP_OnDeath();
 
-	/** Called from the respawn timer to destroy this character and force the PC to respawn */
+	/** Called from the respawn timer. Respawns this character in place, or destroys it to force the PC to spawn a new one */
 	void OnRespawn();
+
+	/** Resets this character and moves it to a player start instead of spawning a new one. Returns false if it couldn't. Server only */
+	bool RespawnInPlace();
+
+	/** Undoes the death state on every machine after an in place respawn */
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastOnRespawn();
+
+	/** Puts the mesh back on the capsule and restores the original collision */
+	void ResetRagdoll();
+
+	/** Called to allow Blueprint code to undo its death effects after an in place respawn */
+	UFUNCTION(BlueprintImplementableEvent, Category="Shooter", meta = (DisplayName = "On Respawn"))
+	void BP_OnRespawn();
 };
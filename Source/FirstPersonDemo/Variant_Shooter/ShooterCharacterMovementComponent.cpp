@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterCharacterMovementComponent.h"
+#include "ShooterGameState.h"
+#include "GameFramework/Character.h"
+#include "Engine/World.h"
+
+void UShooterCharacterMovementComponent::SetWalkSpeeds(float InWalkSpeed, float InBerserkWalkSpeed)
+{
+	MaxWalkSpeed = InWalkSpeed;
+	BerserkWalkSpeed = InBerserkWalkSpeed;
+}
+
+void UShooterCharacterMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	// remote characters on the server get their berserk state from the client's moves
+	if (CharacterOwner && CharacterOwner->IsLocallyControlled())
+	{
+		bBerserk = IsBerserkTime(0.0f);
+	}
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
+
+float UShooterCharacterMovementComponent::GetMaxSpeed() const
+{
+	if (bBerserk && IsMovingOnGround())
+	{
+		return BerserkWalkSpeed;
+	}
+
+	return Super::GetMaxSpeed();
+}
+
+FNetworkPredictionData_Client* UShooterCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (!ClientPredictionData)
+	{
+		UShooterCharacterMovementComponent* MutableThis = const_cast<UShooterCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Shooter(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UShooterCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	const bool bMoveBerserk = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+
+	// replayed moves on the owning client keep the state they were saved with
+	if (!CharacterOwner || CharacterOwner->IsLocallyControlled())
+	{
+		bBerserk = bMoveBerserk;
+		return;
+	}
+
+	// the client's clock can only be a little off from ours. Anything further means we use our own clock
+	const bool bCloseEnough = bMoveBerserk == IsBerserkTime(-BerserkClockTolerance) || bMoveBerserk == IsBerserkTime(BerserkClockTolerance);
+
+	bBerserk = bCloseEnough ? bMoveBerserk : IsBerserkTime(0.0f);
+}
+
+bool UShooterCharacterMovementComponent::IsBerserkTime(float ClockOffset) const
+{
+	const AShooterGameState* GameState = GetWorld()->GetGameState<AShooterGameState>();
+
+	return GameState && GameState->IsBerserkTime(GameState->GetServerWorldTimeSeconds() + ClockOffset);
+}
+
+void FSavedMove_Shooter::Clear()
+{
+	Super::Clear();
+
+	bSavedBerserk = false;
+}
+
+uint8 FSavedMove_Shooter::GetCompressedFlags() const
+{
+	uint8 Flags = Super::GetCompressedFlags();
+
+	if (bSavedBerserk)
+	{
+		Flags |= FLAG_Custom_0;
+	}
+
+	return Flags;
+}
+
+bool FSavedMove_Shooter::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	if (bSavedBerserk != static_cast<const FSavedMove_Shooter*>(NewMove.Get())->bSavedBerserk)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Shooter::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	if (const UShooterCharacterMovementComponent* Movement = Cast<UShooterCharacterMovementComponent>(C->GetCharacterMovement()))
+	{
+		bSavedBerserk = Movement->bBerserk;
+	}
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Shooter::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Shooter());
+}
@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ShooterCharacterMovementComponent.generated.h"
+
+/**
+ *  Character movement for the shooter variant
+ *  Switches to the berserk walk speed during the last seconds of the match, read from the replicated match end time
+ *  The owning client reads the clock and sends the result with its moves, so the speed change is predicted like any other input
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UShooterCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_Shooter;
+
+protected:
+
+	/** If true, moves use the berserk walk speed */
+	bool bBerserk = false;
+
+	/** Walk speed during the berserk phase */
+	float BerserkWalkSpeed = 900.0f;
+
+	/** How far the owning client's match clock may be off from the server's before the server overrides its berserk state */
+	UPROPERTY(EditAnywhere, Category="Berserk", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float BerserkClockTolerance = 1.0f;
+
+public:
+
+	/** Sets the normal and berserk walk speeds */
+	void SetWalkSpeeds(float InWalkSpeed, float InBerserkWalkSpeed);
+
+	/** Returns true if moves are using the berserk walk speed */
+	bool IsBerserk() const { return bBerserk; }
+
+	/** Reads the match clock on the locally controlled copy before the frame's move is saved and performed */
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Uses the berserk walk speed while on the ground */
+	virtual float GetMaxSpeed() const override;
+
+	/** Allocates the saved moves that carry the berserk state */
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+
+	/** Reads the berserk state from the move flags, checking it against the server clock */
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
+	/** Returns true if the match clock, shifted by the given offset, is in the berserk phase */
+	bool IsBerserkTime(float ClockOffset) const;
+};
+
+/**
+ *  Saved move with the berserk state
+ */
+class FSavedMove_Shooter : public FSavedMove_Character
+{
+	using Super = FSavedMove_Character;
+
+public:
+
+	/** Berserk state for this move */
+	uint8 bSavedBerserk : 1;
+
+	virtual void Clear() override;
+
+	virtual uint8 GetCompressedFlags() const override;
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+};
+
+/**
+ *  Client prediction data that allocates shooter saved moves
+ */
+class FNetworkPredictionData_Client_Shooter : public FNetworkPredictionData_Client_Character
+{
+	using Super = FNetworkPredictionData_Client_Character;
+
+public:
+
+	FNetworkPredictionData_Client_Shooter(const UCharacterMovementComponent& ClientMovement) : Super(ClientMovement) {}
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
@@ -0,0 +1,184 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterDamage.h"
+#include "GameFramework/Controller.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_STATS_GROUP(TEXT("ShooterDamage"), STATGROUP_ShooterDamage, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Resolve Damage"), STAT_DamageResolve, STATGROUP_ShooterDamage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events"), STAT_DamageEvents, STATGROUP_ShooterDamage);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Resolved Targets"), STAT_DamageTargets, STATGROUP_ShooterDamage);
+
+static TAutoConsoleVariable<bool> CVarBatchDamage(
+	TEXT("Shooter.BatchDamage"),
+	true,
+	TEXT("If true, damage taken by shooter characters and NPCs is accumulated and applied once per frame instead of once per hit"));
+
+bool FShooterDamageAccumulator::AddDamage(float Damage, AController* Instigator, float CurrentHP, double Time)
+{
+	INC_DWORD_STAT(STAT_DamageEvents);
+
+	// the hit that takes the HP across zero earns the kill, same as if the hits were applied one by one
+	const float HPBeforeHit = CurrentHP - PendingDamage;
+	if (!bPendingKill && HPBeforeHit > 0.0f && HPBeforeHit - Damage <= 0.0f)
+	{
+		bPendingKill = true;
+		KillingInstigator = Instigator;
+	}
+
+	PendingDamage += Damage;
+
+	// merge hits from the same instigator in the same frame so a burst of pellets doesn't flush the history
+	FShooterDamageRecord* Head = HeadRecord != INDEX_NONE ? &Records[HeadRecord] : nullptr;
+	if (Head && Head->Time == Time && Head->Instigator == Instigator)
+	{
+		Head->Damage += Damage;
+
+	} else {
+
+		HeadRecord = (HeadRecord + 1) % MaxRecords;
+		NumRecords = FMath::Min(NumRecords + 1, MaxRecords);
+
+		FShooterDamageRecord& Record = Records[HeadRecord];
+		Record.Instigator = Instigator;
+		Record.Damage = Damage;
+		Record.Time = Time;
+	}
+
+	const bool bFirstHit = !bPending;
+	bPending = true;
+
+	return bFirstHit;
+}
+
+float FShooterDamageAccumulator::ConsumePendingDamage(double Time, AController*& OutKillingInstigator)
+{
+	OutKillingInstigator = nullptr;
+
+	if (bPendingKill)
+	{
+		OutKillingInstigator = KillingInstigator.Get();
+
+		// environment damage finished the target off, so credit whoever hit it last
+		if (!OutKillingInstigator)
+		{
+			OutKillingInstigator = FindRecentInstigator(Time, KillCreditWindow);
+		}
+	}
+
+	const float Damage = PendingDamage;
+
+	PendingDamage = 0.0f;
+	KillingInstigator.Reset();
+	bPendingKill = false;
+	bPending = false;
+
+	return Damage;
+}
+
+AController* FShooterDamageAccumulator::FindRecentInstigator(double Time, double MaxAge) const
+{
+	// walk the ring buffer from newest to oldest
+	for (int32 i = 0; i < NumRecords; ++i)
+	{
+		const FShooterDamageRecord& Record = Records[(HeadRecord - i + MaxRecords) % MaxRecords];
+
+		if (Time - Record.Time > MaxAge)
+		{
+			break;
+		}
+
+		if (AController* Instigator = Record.Instigator.Get())
+		{
+			return Instigator;
+		}
+	}
+
+	return nullptr;
+}
+
+void FShooterDamageAccumulator::Reset()
+{
+	HeadRecord = INDEX_NONE;
+	NumRecords = 0;
+	PendingDamage = 0.0f;
+	KillingInstigator.Reset();
+	bPendingKill = false;
+	bPending = false;
+}
+
+void UShooterDamageSubsystem::QueueTarget(AActor* Target)
+{
+	UWorld* World = Target ? Target->GetWorld() : nullptr;
+	UShooterDamageSubsystem* DamageSubsystem = World ? World->GetSubsystem<UShooterDamageSubsystem>() : nullptr;
+
+	if (DamageSubsystem && CVarBatchDamage.GetValueOnGameThread())
+	{
+		DamageSubsystem->PendingTargets.Add(Target);
+		return;
+	}
+
+	// no batching, apply the hit right away
+	if (IShooterDamageTarget* DamageTarget = Cast<IShooterDamageTarget>(Target))
+	{
+		DamageTarget->ResolvePendingDamage();
+	}
+}
+
+void UShooterDamageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UShooterDamageSubsystem::OnWorldPostActorTick);
+}
+
+void UShooterDamageSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	// anything left is lost with the world
+	PendingTargets.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UShooterDamageSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterDamageSubsystem::OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	// the delegate is global, so skip other worlds
+	if (InWorld == GetWorld())
+	{
+		ResolvePendingTargets();
+	}
+}
+
+void UShooterDamageSubsystem::ResolvePendingTargets()
+{
+	if (PendingTargets.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DamageResolve);
+
+	// deaths can cause more damage, so work on a copy and leave the list open for the next frame
+	TArray<TWeakObjectPtr<AActor>> Targets = MoveTemp(PendingTargets);
+	PendingTargets.Reset();
+
+	for (const TWeakObjectPtr<AActor>& Target : Targets)
+	{
+		if (IShooterDamageTarget* DamageTarget = Cast<IShooterDamageTarget>(Target.Get()))
+		{
+			DamageTarget->ResolvePendingDamage();
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_DamageTargets, Targets.Num());
+}
@@ -0,0 +1,154 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "Containers/StaticArray.h"
+#include "ShooterDamage.generated.h"
+
+class AController;
+
+
+// This class does not need to be modified.
+UINTERFACE(MinimalAPI)
+class UShooterDamageTarget : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ *  Common interface for Shooter Game actors that batch the damage they take each frame
+ */
+class FIRSTPERSONDEMO_API IShooterDamageTarget
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Applies all the damage accumulated this frame in one go */
+	virtual void ResolvePendingDamage() = 0;
+
+	/** Returns true once the target has died and can't be hit anymore */
+	virtual bool IsDead() const = 0;
+};
+
+/**
+ *  A recent hit on a damage target
+ */
+struct FShooterDamageRecord
+{
+	/** Controller that dealt the damage. May be null for environment damage */
+	TWeakObjectPtr<AController> Instigator;
+
+	/** Damage dealt. Hits from the same instigator in the same frame are merged into one record */
+	float Damage = 0.0f;
+
+	/** World time the damage was dealt at */
+	double Time = 0.0;
+};
+
+/**
+ *  Collects the damage a single target takes during a frame so it can be applied in one pass
+ *  Also keeps the last few hits in a fixed-size ring buffer to attribute kills without allocating per hit
+ */
+struct FIRSTPERSONDEMO_API FShooterDamageAccumulator
+{
+	/** Number of recent hits kept for kill attribution */
+	static constexpr int32 MaxRecords = 8;
+
+	/** How long a hit can still earn the kill when the killing damage has no instigator */
+	static constexpr double KillCreditWindow = 5.0;
+
+private:
+
+	/** Ring buffer of recent hits */
+	TStaticArray<FShooterDamageRecord, MaxRecords> Records;
+
+	/** Index of the most recent record */
+	int32 HeadRecord = INDEX_NONE;
+
+	/** Number of valid records in the ring buffer */
+	int32 NumRecords = 0;
+
+	/** Damage taken this frame and not applied yet */
+	float PendingDamage = 0.0f;
+
+	/** Controller whose hit took the HP down to zero this frame */
+	TWeakObjectPtr<AController> KillingInstigator;
+
+	/** If true, one of this frame's hits was lethal */
+	bool bPendingKill = false;
+
+	/** If true, this frame's damage is waiting to be resolved */
+	bool bPending = false;
+
+public:
+
+	/**
+	 *  Adds a hit to this frame's damage
+	 *  @param Damage		Damage dealt by the hit
+	 *  @param Instigator	Controller that dealt the damage
+	 *  @param CurrentHP	Target HP before any of this frame's damage is applied
+	 *  @param Time			Current world time
+	 *  @return true if this is the first hit of the frame and the target needs to be queued for resolution
+	 */
+	bool AddDamage(float Damage, AController* Instigator, float CurrentHP, double Time);
+
+	/**
+	 *  Returns this frame's total damage and clears it
+	 *  @param Time					Current world time
+	 *  @param OutKillingInstigator	Controller credited with the kill if the damage is lethal
+	 */
+	float ConsumePendingDamage(double Time, AController*& OutKillingInstigator);
+
+	/** Returns the most recent instigator that hit the target no earlier than MaxAge seconds ago */
+	AController* FindRecentInstigator(double Time, double MaxAge) const;
+
+	/** Returns true if damage is waiting to be resolved */
+	bool HasPendingDamage() const { return bPending; }
+
+	/** Clears the pending damage and the hit history */
+	void Reset();
+};
+
+/**
+ *  Resolves the damage accumulated by every hit target once per frame, after all actors have ticked
+ *  Many hits on the same target in one frame, like shotgun pellets or explosions, cost a single HP update, replication and UI broadcast
+ *  Only runs on the server
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UShooterDamageSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Targets that took damage this frame */
+	TArray<TWeakObjectPtr<AActor>> PendingTargets;
+
+	/** Handle for the post actor tick delegate */
+	FDelegateHandle PostActorTickHandle;
+
+public:
+
+	/** Queues a target that took its first hit this frame. Resolves it right away if batching is off or there's no subsystem */
+	static void QueueTarget(AActor* Target);
+
+	/** Subsystem initialization */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Subsystem cleanup */
+	virtual void Deinitialize() override;
+
+protected:
+
+	/** Only resolve damage in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Resolves every pending target once all actors have ticked, before replication */
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	/** Resolves every pending target */
+	void ResolvePendingTargets();
+};
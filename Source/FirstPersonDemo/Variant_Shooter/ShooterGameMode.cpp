@@ -8,6 +8,7 @@
 #include "GameFramework/PlayerStart.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 AShooterGameMode::AShooterGameMode()
 {
@@ -110,6 +111,7 @@ uint8 AShooterGameMode::AssignTeamForController(AController* Controller)
 	if (AShooterPlayerController* SPC = Cast<AShooterPlayerController>(Controller))
 	{
 		SPC->TeamId = AssignedTeam;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterPlayerController, TeamId, SPC);
 		//UE_LOG(LogTemp, Log, TEXT("[AssignTeam] %s -> Team %d (SPC->TeamId=%d)"),
 		//	*GetNameSafe(SPC), AssignedTeam, SPC->TeamId);
 	}
@@ -168,6 +170,12 @@ void AShooterGameMode::AdvancePreGameTimer()
 void AShooterGameMode::StartGameCountdown()
 {
 	GetWorldTimerManager().SetTimer(GameTimerHandle, this, &AShooterGameMode::AdvanceGameTimer, 1.0f, true);
+
+	// publish when the match ends so characters can work out the berserk phase from the clock on their own
+	if (AShooterGameState* GS = GetGameState<AShooterGameState>())
+	{
+		GS->Server_SetMatchEndTime(GetWorld()->GetTimeSeconds() + GameCountTime);
+	}
 }
 
 void AShooterGameMode::AdvanceGameTimer()
@@ -3,6 +3,9 @@
 
 #include "Variant_Shooter/ShooterGameState.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "ShooterProjectileReplicator.h"
+#include "Engine/World.h"
 
 AShooterGameState::AShooterGameState()
 {
@@ -11,6 +14,23 @@ AShooterGameState::AShooterGameState()
 	GameCountTime = 0;
 	bReplicates = true;
 	bIsGameOver = false;
+	ProjectileReplicatorClass = AShooterProjectileReplicator::StaticClass();
+}
+
+void AShooterGameState::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// the replicator is spawned on the server and reaches clients through the replicated pointer
+	if (HasAuthority() && ProjectileReplicatorClass)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		ProjectileReplicator = GetWorld()->SpawnActor<AShooterProjectileReplicator>(ProjectileReplicatorClass, SpawnParams);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, ProjectileReplicator, this);
+	}
 }
 
 int32 AShooterGameState::GetScoreForTeam(uint8 Team) const
@@ -35,6 +55,9 @@ void AShooterGameState::Server_SetTeamScore(uint8 Team, int32 Score)
 			TS.Score = Score;
 			LastUpdatedTeam = Team;
 			LastUpdatedScore = Score;
+			MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, TeamScores, this);
+			MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, LastUpdatedTeam, this);
+			MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, LastUpdatedScore, this);
 			// ڷҲͻ˻ͨ OnRep_LastUpdatedScore յ
 			// OnRep_LastUpdatedScore();
 			// ಥпͻ + 
@@ -51,6 +74,9 @@ void AShooterGameState::Server_SetTeamScore(uint8 Team, int32 Score)
 
 	LastUpdatedTeam = Team;
 	LastUpdatedScore = Score;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, TeamScores, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, LastUpdatedTeam, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, LastUpdatedScore, this);
 	// OnRep_LastUpdatedScore();
 	MulticastTeamScoreUpdated(Team, Score);
 }
@@ -59,6 +85,7 @@ void AShooterGameState::Server_SetGameCountTime(int32 NewTime)
 {
 	// ڷϵ
 	GameCountTime = NewTime;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, GameCountTime, this);
 
 	// ڷҲͻͨ OnRep_GameCountTime յ
 	OnRep_GameCountTime();
@@ -68,15 +95,36 @@ void AShooterGameState::Server_SetPreGameCountTime(int32 NewTime)
 {
 	// ڷϵ
 	PreGameCountTime = NewTime;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, PreGameCountTime, this);
 
 	// ڷҲͻͨ OnRep_PreGameCountTime յ
 	OnRep_PreGameCountTime();
 }
 
+void AShooterGameState::Server_SetMatchEndTime(double NewMatchEndTime)
+{
+	MatchEndTime = NewMatchEndTime;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, MatchEndTime, this);
+}
+
+bool AShooterGameState::IsBerserkTime(double ServerTime) const
+{
+	// the match clock hasn't started yet
+	if (MatchEndTime <= 0.0)
+	{
+		return false;
+	}
+
+	const double TimeRemaining = MatchEndTime - ServerTime;
+
+	return TimeRemaining > 0.0 && TimeRemaining <= BerserkDuration;
+}
+
 void AShooterGameState::Server_SetGameOver(bool bNewGameOver)
 {
 	// ڷϵ
 	bIsGameOver = bNewGameOver;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterGameState, bIsGameOver, this);
 
 	// ڷҲֶһΣͻͨ OnRep_GameOver յ
 	OnRep_GameOver();
@@ -119,11 +167,16 @@ void AShooterGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShooterGameState, TeamScores);
-	DOREPLIFETIME(AShooterGameState, LastUpdatedTeam);
-	DOREPLIFETIME(AShooterGameState, LastUpdatedScore);
-	DOREPLIFETIME(AShooterGameState, GameCountTime);
-	DOREPLIFETIME(AShooterGameState, PreGameCountTime);
-	DOREPLIFETIME(AShooterGameState, bIsGameOver);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, TeamScores, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, LastUpdatedTeam, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, LastUpdatedScore, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, GameCountTime, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, PreGameCountTime, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, bIsGameOver, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, MatchEndTime, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterGameState, ProjectileReplicator, Params);
 }
 
@@ -6,6 +6,8 @@
 #include "GameFramework/GameStateBase.h"
 #include "ShooterGameState.generated.h"
 
+class AShooterProjectileReplicator;
+
 /**
  * 
  */
@@ -92,7 +94,36 @@ public:
 	// Gameover״̬
 	void Server_SetGameOver(bool bNewGameOver);
 
+	/** Server time the match ends at. Zero until the match clock starts */
+	UPROPERTY(Replicated)
+	double MatchEndTime = 0.0;
+
+	/** Length of the berserk phase at the end of the match */
+	UPROPERTY(EditDefaultsOnly, Category = "Match", meta = (ClampMin = 0, Units = "s"))
+	float BerserkDuration = 10.0f;
+
+	/** Sets the server time the match ends at. Server only */
+	void Server_SetMatchEndTime(double NewMatchEndTime);
+
+	/** Returns true if the given server time falls in the berserk phase at the end of the match */
+	bool IsBerserkTime(double ServerTime) const;
+
+	/** Returns the manager that replicates projectile spawn and impact events */
+	AShooterProjectileReplicator* GetProjectileReplicator() const { return ProjectileReplicator; }
+
 protected:
+
+	/** Class of the projectile replication manager to spawn */
+	UPROPERTY(EditDefaultsOnly, Category = "Replication")
+	TSubclassOf<AShooterProjectileReplicator> ProjectileReplicatorClass;
+
+	/** Manager that replicates projectile spawn and impact events. Spawned by the server */
+	UPROPERTY(Replicated)
+	TObjectPtr<AShooterProjectileReplicator> ProjectileReplicator;
+
+	/** Spawns the projectile replication manager */
+	virtual void PostInitializeComponents() override;
+
 	UFUNCTION()
 	void OnRep_LastUpdatedScore();
 
@@ -0,0 +1,409 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterLagCompensation.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "ShooterDamage.h"
+#include "FirstPersonDemo.h"
+
+DECLARE_STATS_GROUP(TEXT("LagCompensation"), STATGROUP_LagCompensation, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Record Frame"), STAT_LagCompRecord, STATGROUP_LagCompensation);
+DECLARE_CYCLE_STAT(TEXT("Validate Shot"), STAT_LagCompValidate, STATGROUP_LagCompensation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rewound Shots"), STAT_LagCompShots, STATGROUP_LagCompensation);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Tracked Characters"), STAT_LagCompTracked, STATGROUP_LagCompensation);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Last Rewind Depth (ms)"), STAT_LagCompRewindDepth, STATGROUP_LagCompensation);
+
+static FAutoConsoleCommandWithWorld GLagCompensationDumpCommand(
+	TEXT("LagCompensation.Dump"),
+	TEXT("Logs the rewind depth and validation cost counters for lag compensated shots"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UShooterLagCompensationSubsystem* LagCompensation = World ? World->GetSubsystem<UShooterLagCompensationSubsystem>() : nullptr)
+		{
+			LagCompensation->DumpMetrics();
+		}
+	}));
+
+FHitResult FShooterRewoundHit::MakeHitResult() const
+{
+	FHitResult Hit(Actor, Component, Location, Normal);
+	Hit.ImpactPoint = ImpactPoint;
+	Hit.Distance = Distance;
+
+	return Hit;
+}
+
+void UShooterLagCompensationSubsystem::RegisterCharacter(ACharacter* Character)
+{
+	if (!IsValid(Character) || TrackedCharacters.Contains(Character))
+	{
+		return;
+	}
+
+	if (FreeSlots.Num() == 0)
+	{
+		UE_LOG(LogFirstPersonDemo, Warning, TEXT("Lag compensation is out of slots. %s will not be rewound, so lag compensated shots only hit it where it is on the server"), *GetNameSafe(Character));
+		return;
+	}
+
+	const int32 Slot = FreeSlots.Pop(EAllowShrinking::No);
+	TrackedCharacters[Slot] = Character;
+
+	// clear any history left over from the previous character in this slot
+	for (int32 Frame = 0; Frame < HistoryFrames; ++Frame)
+	{
+		Snapshots[Frame * MaxTrackedCharacters + Slot] = FShooterHitboxSnapshot();
+	}
+
+	SET_DWORD_STAT(STAT_LagCompTracked, MaxTrackedCharacters - FreeSlots.Num());
+}
+
+void UShooterLagCompensationSubsystem::UnregisterCharacter(ACharacter* Character)
+{
+	const int32 Slot = TrackedCharacters.IndexOfByKey(Character);
+
+	if (Slot == INDEX_NONE)
+	{
+		return;
+	}
+
+	TrackedCharacters[Slot] = nullptr;
+	FreeSlots.Add(Slot);
+
+	SET_DWORD_STAT(STAT_LagCompTracked, MaxTrackedCharacters - FreeSlots.Num());
+}
+
+bool UShooterLagCompensationSubsystem::TraceRewound(double RewindTime, const FVector& TraceStart, const FVector& TraceEnd, const AActor* IgnoredActor, FShooterRewoundHit& OutHit, float TraceRadius)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompValidate);
+
+	const FVector TraceDelta = TraceEnd - TraceStart;
+	const float TraceLength = TraceDelta.Size();
+	const FVector TraceDir = TraceLength > UE_KINDA_SMALL_NUMBER ? TraceDelta / TraceLength : FVector::ForwardVector;
+
+	if (NumRecordedFrames == 0)
+	{
+		return TraceUntrackedPawns(TraceStart, TraceDir, TraceLength, IgnoredActor, TraceRadius, OutHit);
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// never rewind further than allowed
+	const double Now = GetWorld()->GetTimeSeconds();
+	RewindTime = FMath::Clamp(RewindTime, Now - MaxRewindTime, Now);
+
+	int32 OlderFrame, NewerFrame;
+	float Alpha;
+	FindFrames(RewindTime, OlderFrame, NewerFrame, Alpha);
+
+	const FShooterHitboxSnapshot* RESTRICT OlderBlock = &Snapshots[OlderFrame * MaxTrackedCharacters];
+	const FShooterHitboxSnapshot* RESTRICT NewerBlock = &Snapshots[NewerFrame * MaxTrackedCharacters];
+
+	int32 HitSlot = INDEX_NONE;
+	float ClosestDistance = TraceLength;
+	FVector HitLocation, HitNormal;
+
+	for (int32 Slot = 0; Slot < MaxTrackedCharacters; ++Slot)
+	{
+		const FShooterHitboxSnapshot& Older = OlderBlock[Slot];
+		const FShooterHitboxSnapshot& Newer = NewerBlock[Slot];
+
+		// skip slots that were empty in either frame
+		if (Older.Radius <= 0.0f || Newer.Radius <= 0.0f)
+		{
+			continue;
+		}
+
+		const FVector Center = FVector(FMath::Lerp(Older.Center, Newer.Center, Alpha));
+
+		// a swept sphere hits the capsule wherever its center enters the capsule grown by the sphere radius
+		float Distance;
+		FVector Location, Normal;
+		if (SegmentHitsCapsule(TraceStart, TraceDir, TraceLength, Center, Newer.HalfHeight + TraceRadius, Newer.Radius + TraceRadius, Distance, Location, Normal) && Distance < ClosestDistance)
+		{
+			// only pay for the weak pointer check on actual candidates. The history may still hold characters that died since
+			const ACharacter* Candidate = TrackedCharacters[Slot].Get();
+			if (Candidate && Candidate != IgnoredActor && !IsHitboxDisabled(Candidate))
+			{
+				HitSlot = Slot;
+				ClosestDistance = Distance;
+				HitLocation = Location;
+				HitNormal = Normal;
+			}
+		}
+	}
+
+	// update the metrics
+	const double RewindDepth = Now - RewindTime;
+	const double ValidationTime = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	++NumRewoundShots;
+	TotalRewindDepth += RewindDepth;
+	PeakRewindDepth = FMath::Max(PeakRewindDepth, RewindDepth);
+	TotalValidationTime += ValidationTime;
+
+	INC_DWORD_STAT(STAT_LagCompShots);
+	SET_FLOAT_STAT(STAT_LagCompRewindDepth, RewindDepth * 1000.0);
+
+	// pawns without a slot have no history, so test them where they are now. Only a hit in front of the rewound one wins
+	if (TraceUntrackedPawns(TraceStart, TraceDir, ClosestDistance, IgnoredActor, TraceRadius, OutHit))
+	{
+		return true;
+	}
+
+	if (HitSlot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	ACharacter* HitCharacter = TrackedCharacters[HitSlot].Get();
+
+	OutHit.Actor = HitCharacter;
+	OutHit.Component = HitCharacter->GetCapsuleComponent();
+	OutHit.Location = HitLocation;
+	OutHit.ImpactPoint = HitLocation - HitNormal * TraceRadius;
+	OutHit.Normal = HitNormal;
+	OutHit.Distance = ClosestDistance;
+
+	return true;
+}
+
+void UShooterLagCompensationSubsystem::DumpMetrics() const
+{
+	const double AvgRewindMs = NumRewoundShots > 0 ? (TotalRewindDepth / NumRewoundShots) * 1000.0 : 0.0;
+	const double AvgValidationUs = NumRewoundShots > 0 ? (TotalValidationTime / NumRewoundShots) * 1000000.0 : 0.0;
+
+	UE_LOG(LogFirstPersonDemo, Log, TEXT("LagCompensation Shots=%d AvgRewind=%.2fms PeakRewind=%.2fms AvgValidation=%.2fus Tracked=%d Frames=%d"),
+		NumRewoundShots, AvgRewindMs, PeakRewindDepth * 1000.0, AvgValidationUs, MaxTrackedCharacters - FreeSlots.Num(), NumRecordedFrames);
+}
+
+void UShooterLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// allocate the whole history up front. Nothing is allocated while recording or rewinding
+	TrackedCharacters.SetNum(MaxTrackedCharacters);
+	Snapshots.SetNum(HistoryFrames * MaxTrackedCharacters);
+	FrameTimes.SetNumZeroed(HistoryFrames);
+
+	FreeSlots.Reserve(MaxTrackedCharacters);
+	for (int32 Slot = MaxTrackedCharacters - 1; Slot >= 0; --Slot)
+	{
+		FreeSlots.Add(Slot);
+	}
+}
+
+void UShooterLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// history is only needed where shots are validated
+	if (GetWorld()->GetNetMode() == NM_Client || FreeSlots.Num() == MaxTrackedCharacters)
+	{
+		return;
+	}
+
+	RecordFrame();
+}
+
+TStatId UShooterLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+bool UShooterLagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterLagCompensationSubsystem::RecordFrame()
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompRecord);
+
+	// advance the ring buffer head
+	HeadFrame = (HeadFrame + 1) % HistoryFrames;
+	NumRecordedFrames = FMath::Min(NumRecordedFrames + 1, HistoryFrames);
+
+	FrameTimes[HeadFrame] = GetWorld()->GetTimeSeconds();
+
+	FShooterHitboxSnapshot* RESTRICT Block = &Snapshots[HeadFrame * MaxTrackedCharacters];
+
+	for (int32 Slot = 0; Slot < MaxTrackedCharacters; ++Slot)
+	{
+		FShooterHitboxSnapshot& Snapshot = Block[Slot];
+
+		const ACharacter* Character = TrackedCharacters[Slot].Get();
+		const UCapsuleComponent* Capsule = Character ? Character->GetCapsuleComponent() : nullptr;
+
+		// dead characters are ragdolls or waiting to respawn, so they leave an empty slot
+		if (!Capsule || IsHitboxDisabled(Character))
+		{
+			Snapshot = FShooterHitboxSnapshot();
+			continue;
+		}
+
+		Snapshot.Center = FVector3f(Capsule->GetComponentLocation());
+		Snapshot.HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+		Snapshot.Radius = Capsule->GetScaledCapsuleRadius();
+	}
+}
+
+bool UShooterLagCompensationSubsystem::TraceUntrackedPawns(const FVector& TraceStart, const FVector& TraceDir, float TraceLength, const AActor* IgnoredActor, float TraceRadius, FShooterRewoundHit& OutHit) const
+{
+	if (TraceLength <= UE_KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LagCompUntrackedPawns), false, IgnoredActor);
+
+	// a zero radius sphere sweep is run as a line trace
+	TArray<FHitResult> Hits;
+	GetWorld()->SweepMultiByObjectType(Hits, TraceStart, TraceStart + TraceDir * TraceLength, FQuat::Identity, FCollisionObjectQueryParams(ECC_Pawn), FCollisionShape::MakeSphere(TraceRadius), QueryParams);
+
+	// hits come back sorted by distance
+	for (const FHitResult& Hit : Hits)
+	{
+		AActor* HitActor = Hit.GetActor();
+
+		if (!HitActor || !HitActor->IsA<APawn>())
+		{
+			continue;
+		}
+
+		// tracked characters were already tested against their rewound capsule
+		if (const ACharacter* HitCharacter = Cast<ACharacter>(HitActor))
+		{
+			if (TrackedCharacters.Contains(HitCharacter))
+			{
+				continue;
+			}
+		}
+
+		OutHit.Actor = HitActor;
+		OutHit.Component = Hit.GetComponent();
+		OutHit.Location = Hit.Location;
+		OutHit.ImpactPoint = Hit.ImpactPoint;
+		OutHit.Normal = Hit.ImpactNormal;
+		OutHit.Distance = Hit.Distance;
+
+		return true;
+	}
+
+	return false;
+}
+
+bool UShooterLagCompensationSubsystem::IsHitboxDisabled(const ACharacter* Character)
+{
+	if (!Character->GetActorEnableCollision())
+	{
+		return true;
+	}
+
+	const IShooterDamageTarget* DamageTarget = Cast<const IShooterDamageTarget>(Character);
+
+	return DamageTarget && DamageTarget->IsDead();
+}
+
+void UShooterLagCompensationSubsystem::FindFrames(double RewindTime, int32& OutOlderFrame, int32& OutNewerFrame, float& OutAlpha) const
+{
+	// default to the latest frame
+	OutOlderFrame = OutNewerFrame = HeadFrame;
+	OutAlpha = 1.0f;
+
+	// walk back from the head until we find a frame at or before the rewind time
+	int32 Frame = HeadFrame;
+	for (int32 i = 0; i < NumRecordedFrames; ++i)
+	{
+		if (FrameTimes[Frame] <= RewindTime)
+		{
+			OutOlderFrame = Frame;
+
+			const double FrameSpan = FrameTimes[OutNewerFrame] - FrameTimes[OutOlderFrame];
+			OutAlpha = FrameSpan > UE_SMALL_NUMBER ? float((RewindTime - FrameTimes[OutOlderFrame]) / FrameSpan) : 1.0f;
+			return;
+		}
+
+		OutNewerFrame = Frame;
+		Frame = (Frame - 1 + HistoryFrames) % HistoryFrames;
+	}
+
+	// the rewind time is older than our history, so clamp to the oldest frame
+	OutOlderFrame = OutNewerFrame;
+	OutAlpha = 0.0f;
+}
+
+bool UShooterLagCompensationSubsystem::SegmentHitsCapsule(const FVector& TraceStart, const FVector& TraceDir, float TraceLength, const FVector& Center, float HalfHeight, float Radius, float& OutDistance, FVector& OutLocation, FVector& OutNormal)
+{
+	// characters keep their capsules upright, so the capsule axis is vertical
+	const float AxisHalfLength = FMath::Max(HalfHeight - Radius, 0.0f);
+	const FVector AxisOffset(0.0f, 0.0f, AxisHalfLength);
+	const FVector AxisBottom = Center - AxisOffset;
+	const FVector AxisTop = Center + AxisOffset;
+
+	const float RadiusSquared = FMath::Square(Radius);
+
+	// work relative to the capsule center
+	const FVector Start = TraceStart - Center;
+
+	float EntryDistance = TraceLength + 1.0f;
+
+	if (FVector::DistSquared(TraceStart, FMath::ClosestPointOnSegment(TraceStart, AxisBottom, AxisTop)) <= RadiusSquared)
+	{
+		// the trace starts inside the capsule
+		EntryDistance = 0.0f;
+
+	} else {
+
+		// the capsule is the union of a cylinder and two spheres, so the trace enters it where it first enters any of them
+		// the cylinder caps sit inside the spheres, so only its side needs testing. It's vertical, so that's a 2D circle test
+		const float A = FMath::Square(TraceDir.X) + FMath::Square(TraceDir.Y);
+		const float B = Start.X * TraceDir.X + Start.Y * TraceDir.Y;
+		const float C = FMath::Square(Start.X) + FMath::Square(Start.Y) - RadiusSquared;
+		const float CylinderDiscriminant = FMath::Square(B) - A * C;
+
+		if (A > UE_SMALL_NUMBER && CylinderDiscriminant >= 0.0f)
+		{
+			const float Distance = (-B - FMath::Sqrt(CylinderDiscriminant)) / A;
+
+			if (Distance >= 0.0f && FMath::Abs(Start.Z + TraceDir.Z * Distance) <= AxisHalfLength)
+			{
+				EntryDistance = Distance;
+			}
+		}
+
+		for (const FVector& SphereCenter : { AxisBottom, AxisTop })
+		{
+			const FVector ToStart = TraceStart - SphereCenter;
+			const float SphereB = FVector::DotProduct(ToStart, TraceDir);
+			const float SphereDiscriminant = FMath::Square(SphereB) - (ToStart.SizeSquared() - RadiusSquared);
+
+			if (SphereDiscriminant >= 0.0f)
+			{
+				const float Distance = -SphereB - FMath::Sqrt(SphereDiscriminant);
+
+				if (Distance >= 0.0f && Distance < EntryDistance)
+				{
+					EntryDistance = Distance;
+				}
+			}
+		}
+	}
+
+	if (EntryDistance > TraceLength)
+	{
+		return false;
+	}
+
+	OutDistance = EntryDistance;
+	OutLocation = TraceStart + TraceDir * OutDistance;
+
+	const FVector SurfaceDir = OutLocation - FMath::ClosestPointOnSegment(OutLocation, AxisBottom, AxisTop);
+	OutNormal = SurfaceDir.IsNearlyZero() ? -TraceDir : SurfaceDir.GetSafeNormal();
+
+	return true;
+}
@@ -0,0 +1,154 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/HitResult.h"
+#include "ShooterLagCompensation.generated.h"
+
+class ACharacter;
+class UPrimitiveComponent;
+
+/**
+ *  Compact capsule snapshot for a single character in a single frame
+ */
+struct FShooterHitboxSnapshot
+{
+	/** Capsule center in world space */
+	FVector3f Center = FVector3f::ZeroVector;
+
+	/** Capsule half height, including the hemispheres */
+	float HalfHeight = 0.0f;
+
+	/** Capsule radius. Zero means the slot was empty this frame */
+	float Radius = 0.0f;
+};
+
+/**
+ *  Result of a trace against rewound hitboxes
+ */
+struct FShooterRewoundHit
+{
+	/** Actor that was hit. A rewound character, or a pawn with no rewind slot hit in the present */
+	AActor* Actor = nullptr;
+
+	/** Component that was hit */
+	UPrimitiveComponent* Component = nullptr;
+
+	/** Where the trace was when it entered the rewound capsule. For swept spheres this is the sphere center */
+	FVector Location = FVector::ZeroVector;
+
+	/** Point on the surface that was hit */
+	FVector ImpactPoint = FVector::ZeroVector;
+
+	/** Surface normal at the hit location */
+	FVector Normal = FVector::ZeroVector;
+
+	/** Distance from the trace start to the hit location */
+	float Distance = 0.0f;
+
+	/** Builds a hit result against the hit component, so the hit can go through the regular damage code */
+	FHitResult MakeHitResult() const;
+};
+
+/**
+ *  Server-side lag compensation for hitscan shots and projectiles
+ *  Records a capsule snapshot for every living registered character each server frame into a fixed-size ring buffer
+ *  Shots are validated by rewinding the capsules to the time the shooting client was seeing. Projectiles do this for every stretch they fly
+ *  Snapshots are stored frame by frame so a rewind only touches two contiguous blocks of memory
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UShooterLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Max number of characters that can be tracked at the same time */
+	static constexpr int32 MaxTrackedCharacters = 64;
+
+	/** Number of frames kept in the history */
+	static constexpr int32 HistoryFrames = 64;
+
+	/** Characters assigned to each snapshot slot */
+	TArray<TWeakObjectPtr<ACharacter>> TrackedCharacters;
+
+	/** Slots not assigned to any character */
+	TArray<int32> FreeSlots;
+
+	/** Ring buffer of snapshots. Frame-major, so frame F uses [F * MaxTrackedCharacters, (F + 1) * MaxTrackedCharacters) */
+	TArray<FShooterHitboxSnapshot> Snapshots;
+
+	/** Server time each frame in the ring buffer was recorded at */
+	TArray<double> FrameTimes;
+
+	/** Index of the most recently recorded frame */
+	int32 HeadFrame = INDEX_NONE;
+
+	/** Number of valid frames in the ring buffer */
+	int32 NumRecordedFrames = 0;
+
+	/** Max amount of time a shot can be rewound */
+	float MaxRewindTime = 0.5f;
+
+	/** Number of shots validated through a rewind */
+	int32 NumRewoundShots = 0;
+
+	/** Sum of all rewind depths, in seconds */
+	double TotalRewindDepth = 0.0;
+
+	/** Deepest rewind so far, in seconds */
+	double PeakRewindDepth = 0.0;
+
+	/** Sum of the time spent validating shots, in seconds */
+	double TotalValidationTime = 0.0;
+
+public:
+
+	/** Starts recording snapshots for the given character. Server only */
+	void RegisterCharacter(ACharacter* Character);
+
+	/** Stops recording snapshots for the given character */
+	void UnregisterCharacter(ACharacter* Character);
+
+	/**
+	 *  Traces a segment against every character capsule as it was at the given server time. Returns the closest hit
+	 *  Pawns without a rewind slot can't be rewound, so they are tested where they are now instead
+	 *  A trace radius sweeps a sphere instead of a line, for projectiles
+	 */
+	bool TraceRewound(double RewindTime, const FVector& TraceStart, const FVector& TraceEnd, const AActor* IgnoredActor, FShooterRewoundHit& OutHit, float TraceRadius = 0.0f);
+
+	/** Returns the max amount of time a shot can be rewound */
+	float GetMaxRewindTime() const { return MaxRewindTime; }
+
+	/** Writes the rewind depth and validation cost counters to the log */
+	void DumpMetrics() const;
+
+	/** Subsystem initialization */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Records a snapshot of every tracked character */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Stat id for the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/** Only track characters in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Writes a new frame into the ring buffer */
+	void RecordFrame();
+
+	/** Sweeps against pawns in the present, skipping the ones that are rewound. Only hits closer than TraceLength count */
+	bool TraceUntrackedPawns(const FVector& TraceStart, const FVector& TraceDir, float TraceLength, const AActor* IgnoredActor, float TraceRadius, FShooterRewoundHit& OutHit) const;
+
+	/** Returns true if the character can't be hit anymore, because it's dead or its collision is off */
+	static bool IsHitboxDisabled(const ACharacter* Character);
+
+	/** Finds the two recorded frames around the given time and the blend between them */
+	void FindFrames(double RewindTime, int32& OutOlderFrame, int32& OutNewerFrame, float& OutAlpha) const;
+
+	/** Returns true if the segment enters the upright capsule. Outputs the entry distance, location and capsule normal. Starting inside counts as a hit at zero distance */
+	static bool SegmentHitsCapsule(const FVector& TraceStart, const FVector& TraceDir, float TraceLength, const FVector& Center, float HalfHeight, float Radius, float& OutDistance, FVector& OutLocation, FVector& OutNormal);
+};
@@ -11,10 +11,12 @@
 #include "Kismet/GameplayStatics.h"
 #include "GameFramework/PlayerStart.h"
 #include "ShooterCharacter.h"
+#include "ShooterWeapon.h"
 #include "ShooterBulletCounterUI.h"
 #include "ShooterUI.h" 
 #include "FirstPersonDemo.h"
 #include "Widgets/Input/SVirtualJoystick.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 void AShooterPlayerController::BeginPlay()
 {
@@ -187,6 +189,7 @@ void AShooterPlayerController::InitializePawn(APawn* InPawn)
 			if (AShooterGameMode* GM = Cast<AShooterGameMode>(GetWorld()->GetAuthGameMode()))
 			{
 				ShooterCharacter->TeamByte = TeamId;
+				MARK_PROPERTY_DIRTY_FROM_NAME(AShooterCharacter, TeamByte, ShooterCharacter);
 			}
 		}
 
@@ -197,11 +200,80 @@ void AShooterPlayerController::InitializePawn(APawn* InPawn)
 		ShooterCharacter->OnBulletCountUpdated.AddDynamic(this, &AShooterPlayerController::OnBulletCountUpdated);
 		ShooterCharacter->OnDamaged.AddDynamic(this, &AShooterPlayerController::OnPawnDamaged);
 
+		// give back the weapons we carried over from the last pawn
+		if (HasAuthority() && StoredWeapons.Num() > 0)
+		{
+			ShooterCharacter->RestoreWeapons(StoredWeapons, StoredWeaponIndex);
+
+			StoredWeapons.Reset();
+			StoredWeaponIndex = INDEX_NONE;
+		}
+
 		// force update the life barȸ 1.0֮ RepNotify ͬʵѪ
 		ShooterCharacter->OnDamaged.Broadcast(1.0f);
 	}
 }
 
+void AShooterPlayerController::StoreWeapons(const TArray<AShooterWeapon*>& Weapons, AShooterWeapon* EquippedWeapon)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	StoredWeapons.Reset(Weapons.Num());
+	StoredWeaponIndex = INDEX_NONE;
+
+	for (AShooterWeapon* Weapon : Weapons)
+	{
+		if (!IsValid(Weapon))
+		{
+			continue;
+		}
+
+		if (Weapon == EquippedWeapon)
+		{
+			StoredWeaponIndex = StoredWeapons.Num();
+		}
+
+		// the controller isn't a weapon holder, so the weapon detaches and hides itself.
+		// It's now destroyed along with the controller instead of the pawn
+		Weapon->SetWeaponHolder(this);
+
+		StoredWeapons.Add(Weapon);
+	}
+}
+
+void AShooterPlayerController::CountAimBytes(int32 NumBytes)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// roll the window over once a second has passed
+	if (Now - AimBytesWindowStart >= 1.0)
+	{
+		// a window that closed over a second ago saw no traffic at all
+		AimBytesLastWindow = Now - AimBytesWindowStart < 2.0 ? AimBytesThisWindow : 0;
+		AimBytesThisWindow = 0;
+		AimBytesWindowStart = Now;
+	}
+
+	AimBytesThisWindow += NumBytes;
+}
+
+int32 AShooterPlayerController::GetAimBytesPerSecond() const
+{
+	const double WindowAge = GetWorld()->GetTimeSeconds() - AimBytesWindowStart;
+
+	// no traffic for over a second
+	if (WindowAge >= 2.0)
+	{
+		return 0;
+	}
+
+	// once the current window has closed it's the last full one
+	return WindowAge >= 1.0 ? AimBytesThisWindow : AimBytesLastWindow;
+}
+
 void AShooterPlayerController::OnPawnDestroyed(AActor* DestroyedActor)
 {
 	// ж˶Ȱѱ UI  0
@@ -292,13 +364,6 @@ void AShooterPlayerController::OnCountdownUpdated(int32 NewTime)
 
 	// 4סһε״̬´ζԱ
 	bWasInBerserk = bIsNowBerserk;
-
-	// 5֪ͨлɫĿ״̬ƶ
-	APawn* Pa = GetPawn();
-	if (AShooterCharacter* Cha = Cast<AShooterCharacter>(Pa))
-	{
-		Cha->ServerSetBerserk(bIsNowBerserk);
-	}
 }
 
 
@@ -436,7 +501,10 @@ void AShooterPlayerController::GetLifetimeReplicatedProps(TArray<FLifetimeProper
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShooterPlayerController, TeamId);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterPlayerController, TeamId, Params);
 }
 
 void AShooterPlayerController::RequestLevelTransition(FString MapName)
@@ -11,6 +11,7 @@
 
 class UInputMappingContext;
 class AShooterCharacter;
+class AShooterWeapon;
 class UShooterBulletCounterUI;
 class UShooterUI;
 
@@ -56,6 +57,22 @@ protected:
 	/** Pointer to the bullet counter UI widget */
 	TObjectPtr<UShooterBulletCounterUI> BulletCounterUI;
 
+	/** Weapons carried over from the last pawn. Handed to the next pawn on respawn instead of spawning new ones */
+	UPROPERTY()
+	TArray<TObjectPtr<AShooterWeapon>> StoredWeapons;
+
+	/** Index in StoredWeapons of the weapon the last pawn had equipped */
+	int32 StoredWeaponIndex = INDEX_NONE;
+
+	/** Aim update bytes received from this connection in the current one second window. Server only */
+	int32 AimBytesThisWindow = 0;
+
+	/** Aim update bytes received from this connection over the last full window. Server only */
+	int32 AimBytesLastWindow = 0;
+
+	/** Time the current aim bytes window started */
+	double AimBytesWindowStart = 0.0;
+
 	/** Type of shooter UI widget to spawn (ͻ˱) */
 	UPROPERTY(EditAnywhere, Category="Shooter|UI")
 	TSubclassOf<UShooterUI> ShooterUIClass;
@@ -118,6 +135,17 @@ protected:
 	UFUNCTION(Server, Reliable)
 	void ServerRequestLevelTransition(const FString& MapName);
 
+public:
+
+	/** Keeps the weapons of a dying pawn detached and hidden until the next pawn is possessed. Server only */
+	void StoreWeapons(const TArray<AShooterWeapon*>& Weapons, AShooterWeapon* EquippedWeapon);
+
+	/** Counts aim update bytes received from this player's connection. Server only */
+	void CountAimBytes(int32 NumBytes);
+
+	/** Returns the aim update bytes per second received from this player's connection. Server only */
+	int32 GetAimBytesPerSecond() const;
+
 public:
 	// ڶ飨 GameMode 䣩
 	UPROPERTY(Replicated, BlueprintReadOnly, Category = "Team")
@@ -0,0 +1,269 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterProjectileBenchmark.h"
+#include "ShooterBenchmarkShooter.h"
+#include "ShooterProjectile.h"
+#include "ShooterImpactEffect.h"
+#include "ShooterBallistics.h"
+#include "ShooterExplosions.h"
+#include "ShooterProjectileTimings.h"
+#include "TargetCube.h"
+#include "FirstPersonDemo.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "HAL/PlatformMisc.h"
+#include "CoreGlobals.h"
+#include "UObject/UObjectGlobals.h"
+
+AShooterProjectileBenchmark::AShooterProjectileBenchmark()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	// sample after everything else has ticked this frame
+	PrimaryActorTick.TickGroup = TG_LastDemotable;
+}
+
+void AShooterProjectileBenchmark::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("ShooterBenchmarkQuit")))
+	{
+		bQuitWhenDone = true;
+	}
+
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &AShooterProjectileBenchmark::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &AShooterProjectileBenchmark::OnPostGarbageCollect);
+
+	if (bStartOnBeginPlay)
+	{
+		StartBenchmark();
+	}
+}
+
+void AShooterProjectileBenchmark::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+}
+
+void AShooterProjectileBenchmark::StartBenchmark()
+{
+	if (bRunning || !WeaponClass)
+	{
+		UE_CLOG(!WeaponClass, LogFirstPersonDemo, Warning, TEXT("Projectile benchmark %s has no weapon class"), *GetName());
+		return;
+	}
+
+	SpawnTargets();
+	SpawnShooters();
+
+	Samples.Reset();
+	Samples.Reserve(FMath::CeilToInt(RecordTime * 120.0f));
+
+	StartTime = GetWorld()->GetTimeSeconds();
+	bRunning = true;
+
+	SetActorTickEnabled(true);
+
+	UE_LOG(LogFirstPersonDemo, Log, TEXT("Projectile benchmark started: %d shooters at %.1f shots/s, %d targets"), Shooters.Num(), ShotsPerSecond, Targets.Num());
+}
+
+void AShooterProjectileBenchmark::FinishBenchmark()
+{
+	if (!bRunning)
+	{
+		return;
+	}
+
+	bRunning = false;
+	SetActorTickEnabled(false);
+
+	for (AShooterBenchmarkShooter* Shooter : Shooters)
+	{
+		if (IsValid(Shooter))
+		{
+			Shooter->StopShooting();
+		}
+	}
+
+	WriteReport();
+
+	if (bQuitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void AShooterProjectileBenchmark::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const double Elapsed = GetWorld()->GetTimeSeconds() - StartTime;
+
+	// drop whatever was measured during the warmup
+	if (Elapsed < WarmupTime)
+	{
+		FShooterProjectileTimings::Reset();
+		PendingGCTime = 0.0;
+		return;
+	}
+
+	const UShooterBallisticsSubsystem* Ballistics = GetWorld()->GetSubsystem<UShooterBallisticsSubsystem>();
+	const UShooterExplosionSubsystem* Explosions = GetWorld()->GetSubsystem<UShooterExplosionSubsystem>();
+
+	FBenchmarkSample& Sample = Samples.AddDefaulted_GetRef();
+	Sample.FrameTime = DeltaSeconds * 1000.0f;
+	Sample.GameThreadTime = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Sample.SpawnTime = FShooterProjectileTimings::GetMilliseconds(EShooterProjectilePhase::Spawn);
+	Sample.MovementTime = FShooterProjectileTimings::GetMilliseconds(EShooterProjectilePhase::Movement);
+	Sample.HitTime = FShooterProjectileTimings::GetMilliseconds(EShooterProjectilePhase::Hit);
+	Sample.ReleaseTime = FShooterProjectileTimings::GetMilliseconds(EShooterProjectilePhase::Release);
+	Sample.GCTime = PendingGCTime * 1000.0;
+	Sample.LiveProjectiles = AShooterProjectile::GetNumLiveProjectiles(GetWorld());
+	Sample.LiveImpactEffects = AShooterImpactEffect::GetNumLiveEffects(GetWorld());
+	Sample.SimulatedRounds = Ballistics ? Ballistics->GetNumRounds() : 0;
+	Sample.QueuedExplosions = Explosions ? Explosions->GetNumQueuedExplosions() : 0;
+
+	FShooterProjectileTimings::Reset();
+	PendingGCTime = 0.0;
+
+	if (Elapsed >= WarmupTime + RecordTime)
+	{
+		FinishBenchmark();
+	}
+}
+
+void AShooterProjectileBenchmark::SpawnTargets()
+{
+	Targets.Reset();
+
+	for (AActor* PlacedTarget : PlacedTargets)
+	{
+		if (PlacedTarget)
+		{
+			Targets.Add(PlacedTarget);
+		}
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	// use a fixed seed so every run gets the same layout
+	FRandomStream LayoutStream(1337);
+
+	auto SpawnScattered = [&](UClass* TargetClass, int32 Count)
+	{
+		if (!TargetClass)
+		{
+			return;
+		}
+
+		for (int32 i = 0; i < Count; ++i)
+		{
+			const FVector2D Offset = FVector2D(LayoutStream.VRand()).GetSafeNormal() * LayoutStream.FRandRange(0.0f, TargetSpreadRadius);
+			const FVector Location = GetActorLocation() + FVector(Offset, LayoutStream.FRandRange(0.0f, 200.0f));
+
+			if (AActor* Target = GetWorld()->SpawnActor<AActor>(TargetClass, FTransform(Location), SpawnParams))
+			{
+				Targets.Add(Target);
+			}
+		}
+	};
+
+	SpawnScattered(PhysicsBodyClass, NumPhysicsBodies);
+	SpawnScattered(TargetCubeClass, NumTargetCubes);
+}
+
+void AShooterProjectileBenchmark::SpawnShooters()
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 i = 0; i < NumShooters; ++i)
+	{
+		// place the shooters on a ring facing the center
+		const float Angle = 2.0f * PI * i / NumShooters;
+		const FVector Location = GetActorLocation() + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * ShooterRingRadius + FVector(0.0f, 0.0f, 100.0f);
+		const FRotator Rotation = (GetActorLocation() - Location).Rotation();
+
+		AShooterBenchmarkShooter* Shooter = GetWorld()->SpawnActor<AShooterBenchmarkShooter>(AShooterBenchmarkShooter::StaticClass(), Location, Rotation, SpawnParams);
+		if (!Shooter)
+		{
+			continue;
+		}
+
+		AActor* Target = Targets.Num() > 0 ? Targets[i % Targets.Num()].Get() : nullptr;
+		Shooter->StartShooting(WeaponClass, Target, ShotsPerSecond);
+
+		Shooters.Add(Shooter);
+	}
+}
+
+void AShooterProjectileBenchmark::WriteReport() const
+{
+	if (Samples.Num() == 0)
+	{
+		UE_LOG(LogFirstPersonDemo, Warning, TEXT("Projectile benchmark recorded no samples"));
+		return;
+	}
+
+	FString Csv = TEXT("Frame,FrameMs,GameThreadMs,SpawnMs,MovementMs,HitMs,ReleaseMs,GCMs,LiveProjectiles,LiveImpactEffects,SimulatedRounds,QueuedExplosions\n");
+
+	FBenchmarkSample Total = {};
+	float PeakGameThreadTime = 0.0f;
+
+	for (int32 i = 0; i < Samples.Num(); ++i)
+	{
+		const FBenchmarkSample& Sample = Samples[i];
+
+		Csv += FString::Printf(TEXT("%d,%.3f,%.3f,%.4f,%.4f,%.4f,%.4f,%.3f,%d,%d,%d,%d\n"), i,
+			Sample.FrameTime, Sample.GameThreadTime, Sample.SpawnTime, Sample.MovementTime, Sample.HitTime, Sample.ReleaseTime, Sample.GCTime,
+			Sample.LiveProjectiles, Sample.LiveImpactEffects, Sample.SimulatedRounds, Sample.QueuedExplosions);
+
+		Total.FrameTime += Sample.FrameTime;
+		Total.GameThreadTime += Sample.GameThreadTime;
+		Total.SpawnTime += Sample.SpawnTime;
+		Total.MovementTime += Sample.MovementTime;
+		Total.HitTime += Sample.HitTime;
+		Total.ReleaseTime += Sample.ReleaseTime;
+		Total.GCTime += Sample.GCTime;
+		Total.LiveProjectiles = FMath::Max(Total.LiveProjectiles, Sample.LiveProjectiles);
+		PeakGameThreadTime = FMath::Max(PeakGameThreadTime, Sample.GameThreadTime);
+	}
+
+	const FString FileName = FPaths::ProfilingDir() / TEXT("ShooterBenchmark") / FString::Printf(TEXT("%s-%s.csv"), *ReportName, *FDateTime::Now().ToString());
+
+	if (FFileHelper::SaveStringToFile(Csv, *FileName))
+	{
+		UE_LOG(LogFirstPersonDemo, Log, TEXT("Projectile benchmark report written to %s"), *FileName);
+
+	} else {
+
+		UE_LOG(LogFirstPersonDemo, Error, TEXT("Failed to write projectile benchmark report to %s"), *FileName);
+	}
+
+	const float Frames = Samples.Num();
+
+	UE_LOG(LogFirstPersonDemo, Log, TEXT("Projectile benchmark: %d frames, avg frame %.2fms, avg game thread %.2fms (peak %.2fms), spawn %.3fms, movement %.3fms, hit %.3fms, release %.3fms, GC %.3fms, peak live projectiles %d"),
+		Samples.Num(), Total.FrameTime / Frames, Total.GameThreadTime / Frames, PeakGameThreadTime,
+		Total.SpawnTime / Frames, Total.MovementTime / Frames, Total.HitTime / Frames, Total.ReleaseTime / Frames, Total.GCTime / Frames,
+		Total.LiveProjectiles);
+}
+
+void AShooterProjectileBenchmark::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void AShooterProjectileBenchmark::OnPostGarbageCollect()
+{
+	PendingGCTime += FPlatformTime::Seconds() - GCStartTime;
+}
@@ -0,0 +1,165 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ShooterProjectileBenchmark.generated.h"
+
+class AShooterWeapon;
+class AShooterBenchmarkShooter;
+class ATargetCube;
+
+/**
+ *  Repeatable projectile stress test
+ *  Spawns a ring of shooters that fire a weapon class at a configurable rate into static geometry, physics bodies and target cubes
+ *  Records per-frame game thread time split into spawn, movement, hit and release, plus GC time and projectile counts
+ *  Writes the samples as CSV to Saved/Profiling/ShooterBenchmark when done
+ *  Runs headless with: -game -nullrhi -ShooterBenchmarkQuit to exit once the CSV has been written
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API AShooterProjectileBenchmark : public AActor
+{
+	GENERATED_BODY()
+
+	/** One recorded frame */
+	struct FBenchmarkSample
+	{
+		float FrameTime;
+		float GameThreadTime;
+		float SpawnTime;
+		float MovementTime;
+		float HitTime;
+		float ReleaseTime;
+		float GCTime;
+		int32 LiveProjectiles;
+		int32 LiveImpactEffects;
+		int32 SimulatedRounds;
+		int32 QueuedExplosions;
+	};
+
+protected:
+
+	/** Weapon fired by every shooter */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Shooters")
+	TSubclassOf<AShooterWeapon> WeaponClass;
+
+	/** Number of shooters to spawn */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Shooters", meta = (ClampMin = 1, ClampMax = 512))
+	int32 NumShooters = 16;
+
+	/** Trigger pulls per second for each shooter. The weapon refire rate still applies */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Shooters", meta = (ClampMin = 0.1, ClampMax = 60))
+	float ShotsPerSecond = 10.0f;
+
+	/** Radius of the ring the shooters are spawned on, around this actor */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Shooters", meta = (ClampMin = 0, Units = "cm"))
+	float ShooterRingRadius = 2000.0f;
+
+	/** Targets placed in the map, such as walls and static meshes. Shooters cycle through every target */
+	UPROPERTY(EditInstanceOnly, Category="Benchmark|Targets")
+	TArray<TObjectPtr<AActor>> PlacedTargets;
+
+	/** Physics body class to spawn as targets */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Targets")
+	TSubclassOf<AActor> PhysicsBodyClass;
+
+	/** Number of physics bodies to spawn */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Targets", meta = (ClampMin = 0, ClampMax = 1000))
+	int32 NumPhysicsBodies = 32;
+
+	/** Target cube class to spawn as targets */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Targets")
+	TSubclassOf<ATargetCube> TargetCubeClass;
+
+	/** Number of target cubes to spawn */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Targets", meta = (ClampMin = 0, ClampMax = 1000))
+	int32 NumTargetCubes = 16;
+
+	/** Radius around this actor the spawned targets are scattered in */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Targets", meta = (ClampMin = 0, Units = "cm"))
+	float TargetSpreadRadius = 800.0f;
+
+	/** Time to let pools fill up and physics settle before recording */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Run", meta = (ClampMin = 0, Units = "s"))
+	float WarmupTime = 3.0f;
+
+	/** Time to record for */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Run", meta = (ClampMin = 1, Units = "s"))
+	float RecordTime = 20.0f;
+
+	/** If true, the benchmark starts as soon as the level begins */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Run")
+	bool bStartOnBeginPlay = true;
+
+	/** If true, the game exits once the CSV has been written. Also enabled by the -ShooterBenchmarkQuit command line switch */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Run")
+	bool bQuitWhenDone = false;
+
+	/** Base name of the CSV file */
+	UPROPERTY(EditAnywhere, Category="Benchmark|Run")
+	FString ReportName = TEXT("ProjectileBenchmark");
+
+	/** Shooters spawned for this run */
+	UPROPERTY()
+	TArray<TObjectPtr<AShooterBenchmarkShooter>> Shooters;
+
+	/** Targets the shooters aim at */
+	TArray<TWeakObjectPtr<AActor>> Targets;
+
+	/** Recorded frames */
+	TArray<FBenchmarkSample> Samples;
+
+	/** Time the benchmark started at */
+	double StartTime = 0.0;
+
+	/** True while the shooters are firing */
+	bool bRunning = false;
+
+	/** Time the current garbage collection started at */
+	double GCStartTime = 0.0;
+
+	/** Garbage collection time since the last sample, in seconds */
+	double PendingGCTime = 0.0;
+
+	/** Delegate handles for the garbage collection timing */
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+
+public:
+
+	/** Constructor */
+	AShooterProjectileBenchmark();
+
+	/** Spawns the targets and shooters and starts recording after the warmup */
+	UFUNCTION(BlueprintCallable, Category="Benchmark")
+	void StartBenchmark();
+
+	/** Stops the shooters and writes the report */
+	UFUNCTION(BlueprintCallable, Category="Benchmark")
+	void FinishBenchmark();
+
+protected:
+
+	/** Gameplay initialization */
+	virtual void BeginPlay() override;
+
+	/** Gameplay cleanup */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+	/** Records a sample per frame once the warmup is over */
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Spawns the physics bodies and target cubes */
+	void SpawnTargets();
+
+	/** Spawns the shooters on a ring and starts them firing */
+	void SpawnShooters();
+
+	/** Writes the samples to a CSV file and logs a summary */
+	void WriteReport() const;
+
+	/** Garbage collection timing */
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+};
@@ -0,0 +1,487 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterReplicationGraph.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+#include "GameFramework/PlayerController.h"
+#include "ShooterCharacter.h"
+#include "ShooterPlayerController.h"
+#include "ShooterNPC.h"
+#include "ShooterWeapon.h"
+#include "ShooterProjectile.h"
+#include "ShooterProjectileReplicator.h"
+#include "HealthPickUp.h"
+#include "TargetCube.h"
+#include "TargetSpawner.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "UObject/UObjectIterator.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "FirstPersonDemo.h"
+
+DECLARE_STATS_GROUP(TEXT("ShooterReplicationGraph"), STATGROUP_ShooterRepGraph, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Rebuild Team Lists"), STAT_RepGraphRebuildTeams, STATGROUP_ShooterRepGraph);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Replication Time (ms)"), STAT_RepGraphTime, STATGROUP_ShooterRepGraph);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Connections"), STAT_RepGraphConnections, STATGROUP_ShooterRepGraph);
+
+static FAutoConsoleCommandWithWorldAndArgs GRepGraphStatsCommand(
+	TEXT("Shooter.RepGraphStats"),
+	TEXT("Logs the server replication time for every connection count seen so far. Pass reset to clear the recorded times"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		UShooterReplicationGraph* Graph = NetDriver ? Cast<UShooterReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+
+		if (!Graph)
+		{
+			UE_LOG(LogFirstPersonDemo, Log, TEXT("The shooter replication graph is not running in this world"));
+			return;
+		}
+
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			Graph->ResetTimings();
+			return;
+		}
+
+		Graph->DumpTimings();
+	}));
+
+void UShooterReplicationGraphNode_Team::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	const UShooterReplicationGraph* Graph = CastChecked<UShooterReplicationGraph>(GetOuter());
+
+	ReplicationActorList.Reset();
+	CurrentTeammates.Reset();
+
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		// our own controller and pawn aren't routed anywhere else
+		ReplicationActorList.ConditionalAdd(Viewer.InViewer);
+		ReplicationActorList.ConditionalAdd(Viewer.ViewTarget);
+
+		const AShooterPlayerController* PlayerController = Cast<AShooterPlayerController>(Viewer.InViewer);
+		if (!PlayerController)
+		{
+			continue;
+		}
+
+		ReplicationActorList.ConditionalAdd(PlayerController->GetPawn());
+
+		const FActorRepListRefView* Team = Graph->GetTeamMembers(PlayerController->TeamId);
+		if (!Team)
+		{
+			continue;
+		}
+
+		Params.OutGatheredReplicationLists.AddReplicationActorList(*Team);
+
+		// teammates replicate at any distance, so the team always knows where everyone is
+		for (int32 i = 0; i < Team->Num(); ++i)
+		{
+			AActor* Teammate = (*Team)[i];
+
+			Params.ConnectionManager.ActorInfoMap.FindOrAdd(Teammate).SetCullDistanceSquared(0.0f);
+			CurrentTeammates.Add(Teammate);
+		}
+	}
+
+	// characters that left the team get their class cull distance back
+	for (const TWeakObjectPtr<AActor>& ExemptActor : CullExemptActors)
+	{
+		AActor* Actor = ExemptActor.Get();
+
+		if (Actor && !CurrentTeammates.Contains(ExemptActor))
+		{
+			const float CullDistanceSquared = GraphGlobals->GlobalActorReplicationInfoMap->Get(Actor).Settings.GetCullDistanceSquared();
+			Params.ConnectionManager.ActorInfoMap.FindOrAdd(Actor).SetCullDistanceSquared(CullDistanceSquared);
+		}
+	}
+
+	Swap(CullExemptActors, CurrentTeammates);
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
+
+void UShooterReplicationGraph::BeginDestroy()
+{
+	AShooterWeapon::OnWeaponHolderChanged.Remove(WeaponHolderChangedHandle);
+
+	Super::BeginDestroy();
+}
+
+void UShooterReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	auto SetPolicy = [this](UClass* Class, EShooterRepNodeMapping Mapping)
+	{
+		ClassRepNodePolicies.Set(Class, Mapping);
+	};
+
+	// only the match state goes to everyone. The projectile replicator carries the GameState's projectile events
+	SetPolicy(AGameStateBase::StaticClass(), EShooterRepNodeMapping::RelevantAllConnections);
+	SetPolicy(APlayerState::StaticClass(), EShooterRepNodeMapping::RelevantAllConnections);
+	SetPolicy(AShooterProjectileReplicator::StaticClass(), EShooterRepNodeMapping::RelevantAllConnections);
+
+	// player controllers only go to their own connection, through the team node
+	SetPolicy(APlayerController::StaticClass(), EShooterRepNodeMapping::NotRouted);
+
+	// everything that moves around the map
+	SetPolicy(AShooterCharacter::StaticClass(), EShooterRepNodeMapping::Spatialize_Dynamic);
+	SetPolicy(AShooterNPC::StaticClass(), EShooterRepNodeMapping::Spatialize_Dynamic);
+	SetPolicy(AShooterProjectile::StaticClass(), EShooterRepNodeMapping::Spatialize_Dynamic);
+	SetPolicy(ATargetCube::StaticClass(), EShooterRepNodeMapping::Spatialize_Dynamic);
+
+	// pickups sit dormant until someone picks them up or they respawn
+	SetPolicy(AHealthPickUp::StaticClass(), EShooterRepNodeMapping::Spatialize_Dormancy);
+
+	// the spawner never moves and has no replicated state or RPCs of its own. The cubes it spawns replicate by themselves,
+	// so under the graph it's spatialized. It keeps bAlwaysRelevant for the default net driver
+	SetPolicy(ATargetSpawner::StaticClass(), EShooterRepNodeMapping::Spatialize_Static);
+
+	// weapons replicate with whoever holds them, see OnWeaponHolderChanged
+	SetPolicy(AShooterWeapon::StaticClass(), EShooterRepNodeMapping::NotRouted);
+
+	// give every replicated class its own settings, so Blueprint subclasses keep the cull distance and update frequency they set up
+	// classes loaded after this point use the settings of their closest loaded parent
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+
+		// skip the editor's skeleton and reinstanced classes
+		if (Class->HasAnyClassFlags(CLASS_NewerVersionExists) || Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (ActorCDO && ActorCDO->GetIsReplicated())
+		{
+			InitClassReplicationInfo(Class);
+		}
+	}
+
+	WeaponHolderChangedHandle = AShooterWeapon::OnWeaponHolderChanged.AddUObject(this, &UShooterReplicationGraph::OnWeaponHolderChanged);
+}
+
+void UShooterReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = FVector2D(SpatialBiasX, SpatialBiasY);
+
+	if (bDisableSpatialRebuilds)
+	{
+		GridNode->AddToClassRebuildDenyList(AActor::StaticClass());
+	}
+
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	// a dedicated server launched by the benchmark script records one connection count, then exits
+	if (FParse::Value(FCommandLine::Get(), TEXT("ShooterRepBenchmark="), BenchmarkConnections) && BenchmarkConnections > 0)
+	{
+		FParse::Value(FCommandLine::Get(), TEXT("ShooterRepBenchmarkSeconds="), BenchmarkDuration);
+
+		UE_LOG(LogFirstPersonDemo, Log, TEXT("Replication benchmark waiting for %d connections"), BenchmarkConnections);
+	}
+}
+
+void UShooterReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UShooterReplicationGraphNode_Team* TeamNode = CreateNewNode<UShooterReplicationGraphNode_Team>();
+	AddConnectionGraphNode(TeamNode, RepGraphConnection);
+}
+
+void UShooterReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EShooterRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EShooterRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case EShooterRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case EShooterRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+
+	// characters also go into the team lists
+	if (AShooterCharacter* Character = Cast<AShooterCharacter>(ActorInfo.Actor))
+	{
+		ShooterCharacters.Add(Character);
+	}
+
+	// weapons go along with the actor holding them
+	if (AShooterWeapon* Weapon = Cast<AShooterWeapon>(ActorInfo.Actor))
+	{
+		SetWeaponDependency(Weapon, Weapon->GetOwner());
+	}
+}
+
+void UShooterReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EShooterRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EShooterRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case EShooterRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case EShooterRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+
+	if (AShooterCharacter* Character = Cast<AShooterCharacter>(ActorInfo.Actor))
+	{
+		ShooterCharacters.RemoveSwap(Character);
+	}
+
+	if (AShooterWeapon* Weapon = Cast<AShooterWeapon>(ActorInfo.Actor))
+	{
+		SetWeaponDependency(Weapon, nullptr);
+	}
+}
+
+int32 UShooterReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	RebuildTeamLists();
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const int32 NumReplicated = Super::ServerReplicateActors(DeltaSeconds);
+
+	const double ReplicationTime = FPlatformTime::Seconds() - StartTime;
+
+	// record the cost against the number of connections it was paid for
+	if (Connections.Num() > 0)
+	{
+		FReplicationTiming& Timing = TimingsByConnections.FindOrAdd(Connections.Num());
+		++Timing.NumFrames;
+		Timing.TotalTime += ReplicationTime;
+		Timing.PeakTime = FMath::Max(Timing.PeakTime, ReplicationTime);
+	}
+
+	SET_FLOAT_STAT(STAT_RepGraphTime, ReplicationTime * 1000.0);
+	SET_DWORD_STAT(STAT_RepGraphConnections, Connections.Num());
+
+	if (BenchmarkConnections > 0)
+	{
+		UpdateBenchmark();
+	}
+
+	return NumReplicated;
+}
+
+void UShooterReplicationGraph::UpdateBenchmark()
+{
+	// wait for every client, then start over so the join phase isn't part of the numbers
+	if (BenchmarkStartTime < 0.0)
+	{
+		if (Connections.Num() >= BenchmarkConnections)
+		{
+			ResetTimings();
+			BenchmarkStartTime = FPlatformTime::Seconds();
+
+			UE_LOG(LogFirstPersonDemo, Log, TEXT("Replication benchmark recording %d connections for %.0f seconds"), Connections.Num(), BenchmarkDuration);
+		}
+
+		return;
+	}
+
+	if (FPlatformTime::Seconds() - BenchmarkStartTime < BenchmarkDuration)
+	{
+		return;
+	}
+
+	DumpTimings();
+	WriteTimingsReport();
+
+	BenchmarkConnections = 0;
+	FPlatformMisc::RequestExit(false);
+}
+
+void UShooterReplicationGraph::DumpTimings() const
+{
+	TArray<int32> ConnectionCounts;
+	TimingsByConnections.GetKeys(ConnectionCounts);
+	ConnectionCounts.Sort();
+
+	UE_LOG(LogFirstPersonDemo, Log, TEXT("Replication graph timings for %d actors:"), GlobalActorReplicationInfoMap.Num());
+
+	for (const int32 NumConnections : ConnectionCounts)
+	{
+		const FReplicationTiming& Timing = TimingsByConnections.FindChecked(NumConnections);
+
+		UE_LOG(LogFirstPersonDemo, Log, TEXT("  %3d connections: %.3f ms avg, %.3f ms peak over %d frames"),
+			NumConnections,
+			Timing.NumFrames > 0 ? Timing.TotalTime / Timing.NumFrames * 1000.0 : 0.0,
+			Timing.PeakTime * 1000.0,
+			Timing.NumFrames);
+	}
+}
+
+void UShooterReplicationGraph::WriteTimingsReport() const
+{
+	TArray<int32> ConnectionCounts;
+	TimingsByConnections.GetKeys(ConnectionCounts);
+	ConnectionCounts.Sort();
+
+	FString Csv = TEXT("Connections,Actors,Frames,AvgMs,PeakMs\n");
+
+	for (const int32 NumConnections : ConnectionCounts)
+	{
+		const FReplicationTiming& Timing = TimingsByConnections.FindChecked(NumConnections);
+
+		Csv += FString::Printf(TEXT("%d,%d,%d,%.4f,%.4f\n"),
+			NumConnections,
+			GlobalActorReplicationInfoMap.Num(),
+			Timing.NumFrames,
+			Timing.NumFrames > 0 ? Timing.TotalTime / Timing.NumFrames * 1000.0 : 0.0,
+			Timing.PeakTime * 1000.0);
+	}
+
+	const FString FileName = FPaths::ProfilingDir() / TEXT("ShooterRepBenchmark") / FString::Printf(TEXT("RepGraph-%d-%s.csv"), BenchmarkConnections, *FDateTime::Now().ToString());
+
+	if (FFileHelper::SaveStringToFile(Csv, *FileName))
+	{
+		UE_LOG(LogFirstPersonDemo, Log, TEXT("Replication benchmark report written to %s"), *FileName);
+
+	} else {
+
+		UE_LOG(LogFirstPersonDemo, Error, TEXT("Failed to write replication benchmark report to %s"), *FileName);
+	}
+}
+
+EShooterRepNodeMapping UShooterReplicationGraph::GetMappingPolicy(UClass* Class)
+{
+	if (const EShooterRepNodeMapping* Policy = ClassRepNodePolicies.Get(Class))
+	{
+		return *Policy;
+	}
+
+	// engine and Blueprint-only classes we don't know about keep their usual relevancy
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	EShooterRepNodeMapping Policy = EShooterRepNodeMapping::Spatialize_Dynamic;
+
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		Policy = EShooterRepNodeMapping::RelevantAllConnections;
+
+		UE_LOG(LogFirstPersonDemo, Verbose, TEXT("%s is always relevant and has no replication graph policy"), *Class->GetName());
+
+	} else if (ActorCDO->bOnlyRelevantToOwner) {
+
+		Policy = EShooterRepNodeMapping::NotRouted;
+	}
+
+	// remember it so the class defaults are only read once
+	ClassRepNodePolicies.Set(Class, Policy);
+
+	return Policy;
+}
+
+void UShooterReplicationGraph::InitClassReplicationInfo(UClass* Class)
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+
+	FClassReplicationInfo ClassInfo;
+
+	// always relevant and owner-only actors aren't in the grid, so a cull distance would only hide them
+	switch (GetMappingPolicy(Class))
+	{
+	case EShooterRepNodeMapping::Spatialize_Static:
+	case EShooterRepNodeMapping::Spatialize_Dynamic:
+	case EShooterRepNodeMapping::Spatialize_Dormancy:
+		ClassInfo.SetCullDistanceSquared(ActorCDO->GetNetCullDistanceSquared());
+		break;
+
+	default:
+		ClassInfo.SetCullDistanceSquared(0.0f);
+		break;
+	}
+
+	ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->GetNetUpdateFrequency());
+
+	GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+}
+
+void UShooterReplicationGraph::OnWeaponHolderChanged(AShooterWeapon* Weapon, AActor* OldHolder, AActor* NewHolder)
+{
+	// the delegate is global, so skip weapons from other worlds and weapons we haven't routed yet
+	if (Weapon->GetWorld() == GetWorld() && GlobalActorReplicationInfoMap.Find(Weapon))
+	{
+		SetWeaponDependency(Weapon, NewHolder);
+	}
+}
+
+void UShooterReplicationGraph::SetWeaponDependency(AShooterWeapon* Weapon, AActor* Holder)
+{
+	if (const TWeakObjectPtr<AActor>* PreviousHolder = WeaponHolders.Find(Weapon))
+	{
+		if (AActor* PreviousHolderActor = PreviousHolder->Get())
+		{
+			GlobalActorReplicationInfoMap.RemoveDependentActor(PreviousHolderActor, Weapon);
+		}
+
+		WeaponHolders.Remove(Weapon);
+	}
+
+	if (Holder)
+	{
+		GlobalActorReplicationInfoMap.AddDependentActor(Holder, Weapon);
+		WeaponHolders.Add(Weapon, Holder);
+	}
+}
+
+void UShooterReplicationGraph::RebuildTeamLists()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RepGraphRebuildTeams);
+
+	for (TPair<uint8, FActorRepListRefView>& Team : TeamMembers)
+	{
+		Team.Value.Reset();
+	}
+
+	// team ids are assigned after the character is spawned, so sort them every frame instead of when they're routed
+	for (AShooterCharacter* Character : ShooterCharacters)
+	{
+		TeamMembers.FindOrAdd(Character->TeamByte).Add(Character);
+	}
+}
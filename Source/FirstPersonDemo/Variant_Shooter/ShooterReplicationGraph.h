@@ -0,0 +1,201 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "ShooterReplicationGraph.generated.h"
+
+class AShooterCharacter;
+class AShooterWeapon;
+
+/**
+ *  How the replication graph routes actors of a given class
+ */
+enum class EShooterRepNodeMapping : uint8
+{
+	/** Not routed to any node. Replicated by the per-connection node if at all */
+	NotRouted,
+
+	/** Routed to the always relevant node */
+	RelevantAllConnections,
+
+	/** Routed to the grid as an actor that never moves */
+	Spatialize_Static,
+
+	/** Routed to the grid as an actor that moves every frame */
+	Spatialize_Dynamic,
+
+	/** Routed to the grid as static while dormant, dynamic while awake */
+	Spatialize_Dormancy,
+};
+
+/**
+ *  Per-connection node for the viewer's own actors and its teammates
+ *  Adds the connection's player controller and pawn, and every character on the viewer's team regardless of distance
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UShooterReplicationGraphNode_Team : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+	/** Viewer actors gathered this frame */
+	FActorRepListRefView ReplicationActorList;
+
+	/** Teammates whose cull distance was lifted for this connection. Restored when they leave the team list */
+	TArray<TWeakObjectPtr<AActor>> CullExemptActors;
+
+	/** Teammates found this frame, used to spot the ones that left */
+	TArray<TWeakObjectPtr<AActor>> CurrentTeammates;
+
+public:
+
+	/** Actors are never routed here directly */
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override {}
+
+	/** Actors are never routed here directly */
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+
+	/** Actors are never routed here directly */
+	virtual void NotifyResetAllNetworkActors() override {}
+
+	/** Gathers the viewer's actors and the team list for the viewer's team */
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
+
+/**
+ *  Replication graph for the Shooter variant
+ *  Characters, NPCs, target cubes and projectiles are spatialized in a 2D grid so each connection only considers nearby actors
+ *  Weapons aren't routed on their own. They replicate as dependents of their holder, so a teammate seen at any distance is seen with their weapon
+ *  Only the GameState, its projectile event replicator and PlayerStates are relevant to every connection
+ *  Pickups are routed through dormancy, so they cost nothing until a pickup or respawn flushes them
+ *  Server replication time is bucketed by connection count and can be read at any time with Shooter.RepGraphStats
+ *  Scripts/RunReplicationBenchmark.py drives a repeatable run: a dedicated server started with -ShooterRepBenchmark=N waits for N headless clients,
+ *  records for -ShooterRepBenchmarkSeconds, writes the buckets as CSV to Saved/Profiling/ShooterRepBenchmark and exits
+ */
+UCLASS(transient, config=Engine)
+class FIRSTPERSONDEMO_API UShooterReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+	/** Replication time recorded at one connection count */
+	struct FReplicationTiming
+	{
+		/** Number of frames recorded */
+		int32 NumFrames = 0;
+
+		/** Sum of the replication time, in seconds */
+		double TotalTime = 0.0;
+
+		/** Slowest frame, in seconds */
+		double PeakTime = 0.0;
+	};
+
+	/** Grid that spatializes most actors */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	/** Actors relevant to every connection */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	/** Routing policy for each class. Subclasses inherit their parent's policy */
+	TClassMap<EShooterRepNodeMapping> ClassRepNodePolicies;
+
+	/** Every replicated shooter character, used to build the team lists */
+	TArray<AShooterCharacter*> ShooterCharacters;
+
+	/** Actor each weapon is registered as a dependent of */
+	TMap<TObjectKey<AShooterWeapon>, TWeakObjectPtr<AActor>> WeaponHolders;
+
+	/** Handle for the weapon holder changed delegate */
+	FDelegateHandle WeaponHolderChangedHandle;
+
+	/** Characters on each team, rebuilt once per frame */
+	TMap<uint8, FActorRepListRefView> TeamMembers;
+
+	/** Replication time for each connection count seen */
+	TMap<int32, FReplicationTiming> TimingsByConnections;
+
+	/** Connection count the command line benchmark waits for. Zero if no benchmark is running */
+	int32 BenchmarkConnections = 0;
+
+	/** Time the command line benchmark records for once every client has joined */
+	float BenchmarkDuration = 30.0f;
+
+	/** Platform time the command line benchmark started recording at. Negative while it's still waiting for clients */
+	double BenchmarkStartTime = -1.0;
+
+protected:
+
+	/** Size of a grid cell */
+	UPROPERTY(config)
+	float GridCellSize = 10000.0f;
+
+	/** World X where the grid starts. Actors further out are clamped to the edge cells */
+	UPROPERTY(config)
+	float SpatialBiasX = -200000.0f;
+
+	/** World Y where the grid starts. Actors further out are clamped to the edge cells */
+	UPROPERTY(config)
+	float SpatialBiasY = -200000.0f;
+
+	/** If true, the grid clamps actors outside its bounds instead of rebuilding itself */
+	UPROPERTY(config)
+	bool bDisableSpatialRebuilds = true;
+
+public:
+
+	/** Stops listening for weapons changing hands */
+	virtual void BeginDestroy() override;
+
+	/** Sets up the routing policies and replication settings for every class */
+	virtual void InitGlobalActorClassSettings() override;
+
+	/** Creates the grid and always relevant nodes */
+	virtual void InitGlobalGraphNodes() override;
+
+	/** Adds the team node to a new connection */
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+
+	/** Routes a new replicated actor to its nodes */
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+
+	/** Removes a replicated actor from its nodes */
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	/** Rebuilds the team lists, replicates and records how long it took */
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/** Returns the characters on the given team, if any */
+	const FActorRepListRefView* GetTeamMembers(uint8 Team) const { return TeamMembers.Find(Team); }
+
+	/** Writes the replication time for every connection count to the log */
+	void DumpTimings() const;
+
+	/** Clears the recorded replication times */
+	void ResetTimings() { TimingsByConnections.Reset(); }
+
+	/** Writes the replication time for every connection count as CSV to Saved/Profiling/ShooterRepBenchmark */
+	void WriteTimingsReport() const;
+
+protected:
+
+	/** Starts recording once every benchmark client has joined, then writes the report and exits when the time is up */
+	void UpdateBenchmark();
+
+	/** Returns the routing policy for a class, deriving it from the class defaults if it wasn't set up explicitly */
+	EShooterRepNodeMapping GetMappingPolicy(UClass* Class);
+
+	/** Sets the cull distance and replication period for a class from its own defaults. Classes that aren't spatialized are never distance culled */
+	void InitClassReplicationInfo(UClass* Class);
+
+	/** Makes a weapon replicate along with its new holder */
+	void OnWeaponHolderChanged(AShooterWeapon* Weapon, AActor* OldHolder, AActor* NewHolder);
+
+	/** Registers a weapon as a dependent of the given holder, removing it from its previous one */
+	void SetWeaponDependency(AShooterWeapon* Weapon, AActor* Holder);
+
+	/** Sorts the characters into their team lists */
+	void RebuildTeamLists();
+};
@@ -0,0 +1,567 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterBallistics.h"
+#include "ShooterProjectile.h"
+#include "ShooterLagCompensation.h"
+#include "ShooterProjectileReplicator.h"
+#include "ShooterProjectileTimings.h"
+#include "ShooterNoise.h"
+#include "Components/SphereComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "WorldCollision.h"
+
+DECLARE_STATS_GROUP(TEXT("ShooterBallistics"), STATGROUP_ShooterBallistics, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Ballistics Tick"), STAT_BallisticsTick, STATGROUP_ShooterBallistics);
+DECLARE_CYCLE_STAT(TEXT("Integrate Rounds"), STAT_BallisticsIntegrate, STATGROUP_ShooterBallistics);
+DECLARE_CYCLE_STAT(TEXT("Sweep Rounds"), STAT_BallisticsSweep, STATGROUP_ShooterBallistics);
+DECLARE_CYCLE_STAT(TEXT("Resolve Impacts"), STAT_BallisticsResolve, STATGROUP_ShooterBallistics);
+DECLARE_CYCLE_STAT(TEXT("Resolve Hitscan"), STAT_BallisticsHitscan, STATGROUP_ShooterBallistics);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Rounds In Flight"), STAT_BallisticsRounds, STATGROUP_ShooterBallistics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sweeps"), STAT_BallisticsSweeps, STATGROUP_ShooterBallistics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impacts"), STAT_BallisticsImpacts, STATGROUP_ShooterBallistics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Shots"), STAT_BallisticsHitscanShots, STATGROUP_ShooterBallistics);
+
+bool UShooterBallisticsSubsystem::FireRound(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* ShotOwner, APawn* ShotInstigator, AActor* DamageCauser, uint32 ReplicationId, float RewindOffset)
+{
+	// rounds are only simulated on the server
+	if (!ProjectileClass || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return false;
+	}
+
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Spawn);
+
+	const int32 ArchetypeIndex = FindOrAddArchetype(ProjectileClass);
+	const FShooterBallisticArchetype& Archetype = Archetypes[ArchetypeIndex];
+
+	Positions.Add(SpawnTransform.GetLocation());
+	PrevPositions.Add(SpawnTransform.GetLocation());
+	Velocities.Add(SpawnTransform.GetRotation().GetForwardVector() * Archetype.Speed);
+	GravityZ.Add(GetWorld()->GetGravityZ() * Archetype.GravityScale);
+	Lifetimes.Add(Archetype.Lifetime);
+	StepTimes.Add(0.0f);
+	CarriedTimes.Add(0.0f);
+	BounceCounts.Add(0);
+	ArchetypeIndices.Add(ArchetypeIndex);
+	Owners.Add(ShotOwner);
+	Instigators.Add(ShotInstigator);
+	Causers.Add(DamageCauser);
+	ReplicationIds.Add(ReplicationId);
+	RewindOffsets.Add(RewindOffset);
+
+	SET_DWORD_STAT(STAT_BallisticsRounds, Positions.Num());
+
+	return true;
+}
+
+bool UShooterBallisticsSubsystem::FireHitscan(TSubclassOf<AShooterProjectile> ProjectileClass, const FVector& TraceStart, const FVector& TraceEnd, AActor* ShotOwner, APawn* ShotInstigator, AActor* DamageCauser, double RewindTime)
+{
+	// hitscan shots are only resolved on the server
+	if (!ProjectileClass || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return false;
+	}
+
+	PendingHitscanShots.Add({ TraceStart, TraceEnd, RewindTime, FindOrAddArchetype(ProjectileClass), ShotOwner, ShotInstigator, DamageCauser });
+
+	return true;
+}
+
+void UShooterBallisticsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// reserve up front so firing never has to grow the arrays in the middle of a fight
+	Positions.Reserve(InitialRoundCapacity);
+	PrevPositions.Reserve(InitialRoundCapacity);
+	Velocities.Reserve(InitialRoundCapacity);
+	GravityZ.Reserve(InitialRoundCapacity);
+	Lifetimes.Reserve(InitialRoundCapacity);
+	StepTimes.Reserve(InitialRoundCapacity);
+	CarriedTimes.Reserve(InitialRoundCapacity);
+	BounceCounts.Reserve(InitialRoundCapacity);
+	ArchetypeIndices.Reserve(InitialRoundCapacity);
+	Owners.Reserve(InitialRoundCapacity);
+	Instigators.Reserve(InitialRoundCapacity);
+	Causers.Reserve(InitialRoundCapacity);
+	ReplicationIds.Reserve(InitialRoundCapacity);
+	RewindOffsets.Reserve(InitialRoundCapacity);
+	InFlightSweeps.Reserve(InitialRoundCapacity);
+	PendingImpacts.Reserve(256);
+	PendingHitscanShots.Reserve(256);
+	InFlightHitscanShots.Reserve(256);
+}
+
+void UShooterBallisticsSubsystem::Deinitialize()
+{
+	Positions.Empty();
+	PrevPositions.Empty();
+	Velocities.Empty();
+	GravityZ.Empty();
+	Lifetimes.Empty();
+	StepTimes.Empty();
+	CarriedTimes.Empty();
+	BounceCounts.Empty();
+	ArchetypeIndices.Empty();
+	Owners.Empty();
+	Instigators.Empty();
+	Causers.Empty();
+	ReplicationIds.Empty();
+	RewindOffsets.Empty();
+	InFlightSweeps.Empty();
+	PendingImpacts.Empty();
+	PendingHitscanShots.Empty();
+	InFlightHitscanShots.Empty();
+
+	SET_DWORD_STAT(STAT_BallisticsRounds, 0);
+
+	Super::Deinitialize();
+}
+
+void UShooterBallisticsSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Positions.Num() == 0 && PendingHitscanShots.Num() == 0 && InFlightHitscanShots.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsTick);
+
+	// resolve last frame's hitscan traces, then send off this frame's shots
+	ResolveHitscanShots();
+
+	IssueHitscanTraces();
+
+	if (Positions.Num() == 0)
+	{
+		return;
+	}
+
+	// last frame's sweeps have had a whole frame to complete, so resolve them before moving the rounds again
+	GatherSweepResults();
+
+	ResolveImpacts();
+
+	RemoveDeadRounds();
+
+	IntegrateRounds(DeltaTime);
+
+	IssueSweeps();
+
+	SET_DWORD_STAT(STAT_BallisticsRounds, Positions.Num());
+}
+
+TStatId UShooterBallisticsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterBallisticsSubsystem, STATGROUP_Tickables);
+}
+
+bool UShooterBallisticsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+int32 UShooterBallisticsSubsystem::FindOrAddArchetype(TSubclassOf<AShooterProjectile> ProjectileClass)
+{
+	if (const int32* ExistingIndex = ArchetypeLookup.Find(ProjectileClass.Get()))
+	{
+		return *ExistingIndex;
+	}
+
+	// read the settings from the projectile class defaults
+	const AShooterProjectile* ProjectileCDO = ProjectileClass->GetDefaultObject<AShooterProjectile>();
+
+	FShooterBallisticArchetype Archetype;
+	Archetype.ProjectileClass = ProjectileClass;
+	Archetype.HitParams = ProjectileCDO->GetHitParams();
+	Archetype.MaxBounces = ProjectileCDO->GetMaxSimulatedBounces();
+	Archetype.Lifetime = ProjectileCDO->GetMaxSimulatedLifetime();
+
+	if (const USphereComponent* Collision = ProjectileCDO->GetCollisionComponent())
+	{
+		Archetype.Radius = Collision->GetUnscaledSphereRadius();
+		Archetype.CollisionChannel = Collision->GetCollisionObjectType();
+		Archetype.ResponseParams = FCollisionResponseParams(Collision->GetCollisionResponseToChannels());
+	}
+
+	Archetype.WorldResponseParams = Archetype.ResponseParams;
+	Archetype.WorldResponseParams.CollisionResponse.SetResponse(ECC_Pawn, ECR_Ignore);
+
+	if (const UProjectileMovementComponent* Movement = ProjectileCDO->GetProjectileMovement())
+	{
+		Archetype.Speed = Movement->InitialSpeed;
+		Archetype.GravityScale = Movement->ProjectileGravityScale;
+		Archetype.Bounciness = Movement->bShouldBounce ? Movement->Bounciness : 0.0f;
+		Archetype.Friction = Movement->Friction;
+	}
+
+	const int32 NewIndex = Archetypes.Add(Archetype);
+	ArchetypeLookup.Add(ProjectileClass.Get(), NewIndex);
+
+	return NewIndex;
+}
+
+void UShooterBallisticsSubsystem::IntegrateRounds(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsIntegrate);
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Movement);
+
+	const int32 NumRounds = Positions.Num();
+
+	// work on raw pointers so the loop stays tight and the compiler is free to vectorize it
+	FVector* RESTRICT Position = Positions.GetData();
+	FVector* RESTRICT PrevPosition = PrevPositions.GetData();
+	FVector* RESTRICT Velocity = Velocities.GetData();
+	const float* RESTRICT Gravity = GravityZ.GetData();
+	float* RESTRICT Lifetime = Lifetimes.GetData();
+	float* RESTRICT StepTime = StepTimes.GetData();
+	float* RESTRICT CarriedTime = CarriedTimes.GetData();
+
+	for (int32 i = 0; i < NumRounds; ++i)
+	{
+		// rounds that bounced last frame also fly the part of that frame left after the bounce
+		StepTime[i] = DeltaTime + CarriedTime[i];
+		CarriedTime[i] = 0.0f;
+
+		PrevPosition[i] = Position[i];
+		Velocity[i].Z += Gravity[i] * StepTime[i];
+		Position[i] += Velocity[i] * StepTime[i];
+		Lifetime[i] -= DeltaTime;
+	}
+}
+
+void UShooterBallisticsSubsystem::IssueSweeps()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsSweep);
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Movement);
+
+	UWorld* World = GetWorld();
+
+	const bool bCanRewind = World->GetSubsystem<UShooterLagCompensationSubsystem>() != nullptr;
+	SweepTime = World->GetTimeSeconds();
+
+	// reuse the same query params for the whole batch. Only the ignored actors change per round
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterBallistics), false);
+
+	const int32 NumRounds = Positions.Num();
+
+	for (int32 i = 0; i < NumRounds; ++i)
+	{
+		// skip rounds that ran out of flight time
+		if (Lifetimes[i] <= 0.0f)
+		{
+			continue;
+		}
+
+		const FShooterBallisticArchetype& Archetype = Archetypes[ArchetypeIndices[i]];
+
+		// ignore the pawn that shot this round, same as the projectile actor does
+		QueryParams.ClearIgnoredActors();
+		QueryParams.AddIgnoredActor(Instigators[i].Get());
+
+		// lag compensated rounds sweep the world without pawns. Characters are tested at their rewound positions when the result comes back
+		const FCollisionResponseParams& ResponseParams = bCanRewind && RewindOffsets[i] > 0.0f ? Archetype.WorldResponseParams : Archetype.ResponseParams;
+
+		const FTraceHandle Handle = World->AsyncSweepByChannel(EAsyncTraceType::Single, PrevPositions[i], Positions[i], FQuat::Identity, Archetype.CollisionChannel, FCollisionShape::MakeSphere(Archetype.Radius), QueryParams, ResponseParams);
+
+		InFlightSweeps.Add({ i, Handle });
+	}
+
+	INC_DWORD_STAT_BY(STAT_BallisticsSweeps, InFlightSweeps.Num());
+}
+
+void UShooterBallisticsSubsystem::GatherSweepResults()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsSweep);
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Movement);
+
+	PendingImpacts.Reset();
+
+	if (InFlightSweeps.Num() == 0)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	UShooterLagCompensationSubsystem* LagCompensation = World->GetSubsystem<UShooterLagCompensationSubsystem>();
+
+	FTraceDatum TraceData;
+
+	for (const FPendingSweep& Sweep : InFlightSweeps)
+	{
+		const int32 i = Sweep.RoundIndex;
+		const FShooterBallisticArchetype& Archetype = Archetypes[ArchetypeIndices[i]];
+		const bool bRewind = RewindOffsets[i] > 0.0f && LagCompensation;
+
+		FHitResult Hit;
+		bool bHit = false;
+
+		if (World->QueryTraceData(Sweep.Handle, TraceData))
+		{
+			if (const FHitResult* BlockingHit = FHitResult::GetFirstBlockingHit(TraceData.OutHits))
+			{
+				Hit = *BlockingHit;
+				bHit = true;
+			}
+
+		} else {
+
+			// the result didn't make it back in time. Sweep now rather than let the round pass through a wall
+			FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterBallistics), false, Instigators[i].Get());
+			bHit = World->SweepSingleByChannel(Hit, PrevPositions[i], Positions[i], FQuat::Identity, Archetype.CollisionChannel, FCollisionShape::MakeSphere(Archetype.Radius), QueryParams, bRewind ? Archetype.WorldResponseParams : Archetype.ResponseParams);
+		}
+
+		if (bRewind)
+		{
+			// only characters in front of the world hit count
+			FShooterRewoundHit RewoundHit;
+			if (LagCompensation->TraceRewound(SweepTime - RewindOffsets[i], PrevPositions[i], bHit ? Hit.Location : Positions[i], Instigators[i].Get(), RewoundHit, Archetype.Radius))
+			{
+				Hit = RewoundHit.MakeHitResult();
+				bHit = true;
+			}
+		}
+
+		if (bHit)
+		{
+			PendingImpacts.Add({ i, MoveTemp(Hit) });
+		}
+	}
+
+	InFlightSweeps.Reset();
+
+	INC_DWORD_STAT_BY(STAT_BallisticsImpacts, PendingImpacts.Num());
+}
+
+void UShooterBallisticsSubsystem::ResolveImpacts()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsResolve);
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Hit);
+
+	for (const FPendingImpact& Impact : PendingImpacts)
+	{
+		const int32 i = Impact.RoundIndex;
+		const FHitResult& Hit = Impact.Hit;
+
+		const FShooterBallisticArchetype& Archetype = Archetypes[ArchetypeIndices[i]];
+
+		// bounce off anything that isn't a pawn while we still have bounces left
+		if (BounceCounts[i] < Archetype.MaxBounces && !Cast<APawn>(Hit.GetActor()))
+		{
+			const FVector Normal = Hit.ImpactNormal;
+			const FVector NormalVelocity = Normal * FVector::DotProduct(Velocities[i], Normal);
+			const FVector TangentVelocity = Velocities[i] - NormalVelocity;
+
+			Velocities[i] = TangentVelocity * (1.0f - Archetype.Friction) - NormalVelocity * Archetype.Bounciness;
+			// push the round off the surface so its next sweep doesn't start inside it
+			Positions[i] = Hit.Location + Normal * BounceSkinWidth;
+
+			// keep the part of the step left after the bounce. It's flown along the new velocity on the next step
+			CarriedTimes[i] = (1.0f - Hit.Time) * StepTimes[i];
+
+			++BounceCounts[i];
+			continue;
+		}
+
+		ResolveRoundHit(i, Hit);
+	}
+}
+
+void UShooterBallisticsSubsystem::ResolveRoundHit(int32 RoundIndex, const FHitResult& Hit)
+{
+	// flag the round for removal
+	Lifetimes[RoundIndex] = 0.0f;
+
+	// stop the cosmetic copy on clients
+	if (AShooterProjectileReplicator* Replicator = AShooterProjectileReplicator::Get(GetWorld()))
+	{
+		Replicator->AddImpactEvent(ReplicationIds[RoundIndex], Hit.ImpactPoint, Hit.ImpactNormal);
+	}
+
+	// clients already know about this one, so it's not reported again as expired
+	ReplicationIds[RoundIndex] = 0;
+
+	AActor* DamageCauser = Causers[RoundIndex].Get();
+
+	// drop the round if the weapon that fired it is gone
+	if (!DamageCauser)
+	{
+		return;
+	}
+
+	ApplyHit(Archetypes[ArchetypeIndices[RoundIndex]], DamageCauser, Owners[RoundIndex].Get(), Instigators[RoundIndex].Get(), Hit);
+}
+
+void UShooterBallisticsSubsystem::IssueHitscanTraces()
+{
+	if (PendingHitscanShots.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsHitscan);
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Hit);
+
+	UWorld* World = GetWorld();
+
+	const bool bCanRewind = World->GetSubsystem<UShooterLagCompensationSubsystem>() != nullptr;
+
+	// reuse the same query params for the whole batch. Only the ignored actors change per shot
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterHitscan), false);
+
+	for (FPendingHitscanShot& Shot : PendingHitscanShots)
+	{
+		const FShooterBallisticArchetype& Archetype = Archetypes[Shot.ArchetypeIndex];
+
+		QueryParams.ClearIgnoredActors();
+		QueryParams.AddIgnoredActor(Shot.Causer.Get());
+		QueryParams.AddIgnoredActor(Shot.Instigator.Get());
+
+		// lag compensated shots trace the world without pawns. Characters are tested at their rewound positions when the result comes back
+		const FCollisionResponseParams& ResponseParams = bCanRewind && Shot.RewindTime > 0.0 ? Archetype.WorldResponseParams : Archetype.ResponseParams;
+
+		Shot.Handle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Shot.TraceStart, Shot.TraceEnd, Archetype.CollisionChannel, QueryParams, ResponseParams);
+	}
+
+	INC_DWORD_STAT_BY(STAT_BallisticsHitscanShots, PendingHitscanShots.Num());
+
+	// the in-flight list was emptied when its results were resolved, so the two lists can just trade places
+	Swap(PendingHitscanShots, InFlightHitscanShots);
+}
+
+void UShooterBallisticsSubsystem::ResolveHitscanShots()
+{
+	if (InFlightHitscanShots.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_BallisticsHitscan);
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Hit);
+
+	UWorld* World = GetWorld();
+
+	UShooterLagCompensationSubsystem* LagCompensation = World->GetSubsystem<UShooterLagCompensationSubsystem>();
+
+	FTraceDatum TraceData;
+
+	for (const FPendingHitscanShot& Shot : InFlightHitscanShots)
+	{
+		AActor* DamageCauser = Shot.Causer.Get();
+
+		// drop the shot if the weapon that fired it is gone
+		if (!DamageCauser)
+		{
+			continue;
+		}
+
+		const FShooterBallisticArchetype& Archetype = Archetypes[Shot.ArchetypeIndex];
+		const bool bRewind = Shot.RewindTime > 0.0 && LagCompensation;
+
+		FHitResult Hit;
+		bool bHit = false;
+
+		if (World->QueryTraceData(Shot.Handle, TraceData))
+		{
+			if (const FHitResult* BlockingHit = FHitResult::GetFirstBlockingHit(TraceData.OutHits))
+			{
+				Hit = *BlockingHit;
+				bHit = true;
+			}
+
+		} else {
+
+			// the result didn't make it back in time, so trace it now
+			FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterHitscan), false, DamageCauser);
+			QueryParams.AddIgnoredActor(Shot.Instigator.Get());
+
+			bHit = World->LineTraceSingleByChannel(Hit, Shot.TraceStart, Shot.TraceEnd, Archetype.CollisionChannel, QueryParams, bRewind ? Archetype.WorldResponseParams : Archetype.ResponseParams);
+		}
+
+		if (bRewind)
+		{
+			// only characters in front of the world hit count
+			FShooterRewoundHit RewoundHit;
+			if (LagCompensation->TraceRewound(Shot.RewindTime, Shot.TraceStart, bHit ? Hit.Location : Shot.TraceEnd, Shot.Instigator.Get(), RewoundHit))
+			{
+				Hit = RewoundHit.MakeHitResult();
+				bHit = true;
+			}
+		}
+
+		if (bHit)
+		{
+			ApplyHit(Archetype, DamageCauser, Shot.Owner.Get(), Shot.Instigator.Get(), Hit);
+		}
+	}
+
+	InFlightHitscanShots.Reset();
+}
+
+void UShooterBallisticsSubsystem::ApplyHit(const FShooterBallisticArchetype& Archetype, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, const FHitResult& Hit)
+{
+	const FShooterProjectileHitParams& Params = Archetype.HitParams;
+
+	// make AI perception noise
+	UShooterNoiseSubsystem::ReportNoise(DamageCauser, Params.NoiseLoudness, ShotInstigator, Hit.Location, Params.NoiseRange, Params.NoiseTag);
+
+	if (Params.bExplodeOnHit)
+	{
+		// apply explosion damage centered on the hit
+		AShooterProjectile::ApplyProjectileExplosion(GetWorld(), Params, DamageCauser, ShotOwner, ShotInstigator, Hit.Location);
+
+	} else {
+
+		// single hit. Process the collided actor
+		AShooterProjectile::ApplyProjectileHit(Params, DamageCauser, ShotOwner, ShotInstigator, Hit.GetActor(), Hit.GetComponent(), Hit.ImpactPoint, -Hit.ImpactNormal);
+	}
+}
+
+void UShooterBallisticsSubsystem::RemoveDeadRounds()
+{
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Release);
+
+	AShooterProjectileReplicator* Replicator = AShooterProjectileReplicator::Get(GetWorld());
+
+	// walk backwards so swapped-in rounds have already been checked
+	for (int32 i = Positions.Num() - 1; i >= 0; --i)
+	{
+		if (Lifetimes[i] <= 0.0f)
+		{
+			// rounds that hit something already sent their impact. The rest ran out of flight time and clients still need to stop their copy
+			if (Replicator && ReplicationIds[i] != 0)
+			{
+				Replicator->AddExpiryEvent(ReplicationIds[i], Positions[i]);
+			}
+
+			RemoveRoundAtSwap(i);
+		}
+	}
+}
+
+void UShooterBallisticsSubsystem::RemoveRoundAtSwap(int32 RoundIndex)
+{
+	Positions.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	PrevPositions.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	Velocities.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	GravityZ.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	Lifetimes.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	StepTimes.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	CarriedTimes.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	BounceCounts.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	ArchetypeIndices.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	Owners.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	Instigators.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	Causers.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	ReplicationIds.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+	RewindOffsets.RemoveAtSwap(RoundIndex, 1, EAllowShrinking::No);
+}
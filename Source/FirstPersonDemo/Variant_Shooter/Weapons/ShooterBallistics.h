@@ -0,0 +1,238 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "CollisionQueryParams.h"
+#include "ShooterProjectile.h"
+#include "ShooterBallistics.generated.h"
+
+class APawn;
+
+/**
+ *  Flight and hit settings shared by every simulated round of a projectile class
+ *  Read once from the projectile class defaults so rounds only need to store an index
+ */
+USTRUCT()
+struct FShooterBallisticArchetype
+{
+	GENERATED_BODY()
+
+	/** Projectile class these settings were read from */
+	UPROPERTY()
+	TSubclassOf<AShooterProjectile> ProjectileClass;
+
+	/** Damage, explosion and noise settings */
+	UPROPERTY()
+	FShooterProjectileHitParams HitParams;
+
+	/** Radius of the swept sphere */
+	float Radius = 16.0f;
+
+	/** Launch speed */
+	float Speed = 3000.0f;
+
+	/** Multiplier applied to the world gravity */
+	float GravityScale = 1.0f;
+
+	/** Fraction of the normal velocity kept after a bounce */
+	float Bounciness = 0.6f;
+
+	/** Fraction of the tangent velocity lost after a bounce */
+	float Friction = 0.2f;
+
+	/** Number of bounces off non-pawn surfaces before the round resolves its hit */
+	int32 MaxBounces = 0;
+
+	/** Max flight time */
+	float Lifetime = 10.0f;
+
+	/** Channel used for the sweeps */
+	TEnumAsByte<ECollisionChannel> CollisionChannel = ECC_WorldDynamic;
+
+	/** Collision responses copied from the projectile collision sphere */
+	FCollisionResponseParams ResponseParams;
+
+	/** Collision responses with pawns ignored. Used by lag compensated shots, which hit characters at their rewound positions instead */
+	FCollisionResponseParams WorldResponseParams;
+};
+
+/**
+ *  Simulates projectiles as plain data instead of actors
+ *  Rounds are stored as structure-of-arrays, integrated in one pass per frame and then swept in one batch of async sweeps
+ *  The sweep results are read back and resolved on the next frame
+ *  Also collects the hitscan shots fired during the frame and traces them in one batch of async traces, resolved on the next frame
+ *  Hits go through the same damage and explosion code as AShooterProjectile
+ *  Rounds only exist on the server. Clients simulate cosmetic copies from the replicator's spawn events, which are stopped by its impact and expiry events
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UShooterBallisticsSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Cached per-class settings. Indexed by ArchetypeIndices */
+	UPROPERTY()
+	TArray<FShooterBallisticArchetype> Archetypes;
+
+	/** Maps a projectile class to its index in the archetype list */
+	TMap<TObjectKey<UClass>, int32> ArchetypeLookup;
+
+	/** Current round positions */
+	TArray<FVector> Positions;
+
+	/** Round positions at the start of the frame. Sweeps go from here to the current position */
+	TArray<FVector> PrevPositions;
+
+	/** Round velocities */
+	TArray<FVector> Velocities;
+
+	/** Gravity acceleration applied to each round */
+	TArray<float> GravityZ;
+
+	/** Remaining flight time for each round. Rounds at or under zero are removed at the end of the frame */
+	TArray<float> Lifetimes;
+
+	/** Flight time covered by each round's last step, including time carried over from a bounce */
+	TArray<float> StepTimes;
+
+	/** Flight time left over from a bounce, flown on the round's next step */
+	TArray<float> CarriedTimes;
+
+	/** Number of bounces each round has done */
+	TArray<int32> BounceCounts;
+
+	/** Archetype used by each round */
+	TArray<int32> ArchetypeIndices;
+
+	/** Actor that owns each round, usually the character holding the weapon */
+	TArray<TWeakObjectPtr<AActor>> Owners;
+
+	/** Pawn that fired each round */
+	TArray<TWeakObjectPtr<APawn>> Instigators;
+
+	/** Actor reported as the damage causer for each round, usually the weapon */
+	TArray<TWeakObjectPtr<AActor>> Causers;
+
+	/** Replication id of each round, used to stop the clients' cosmetic copy on impact */
+	TArray<uint32> ReplicationIds;
+
+	/** How far behind the server the shooting client was seeing the world. Characters are hit at their positions that long ago */
+	TArray<float> RewindOffsets;
+
+	/** An async sweep issued for a round */
+	struct FPendingSweep
+	{
+		int32 RoundIndex;
+		FTraceHandle Handle;
+	};
+
+	/** Sweeps issued last frame. Rounds are only ever appended until the results are read, so the indices stay valid */
+	TArray<FPendingSweep> InFlightSweeps;
+
+	/** Server time the in-flight sweeps were issued at. Lag compensated rounds rewind from here */
+	double SweepTime = 0.0;
+
+	/** A sweep hit found during the batched sweep pass */
+	struct FPendingImpact
+	{
+		int32 RoundIndex;
+		FHitResult Hit;
+	};
+
+	/** Sweep hits found this frame. Kept around to avoid reallocating every frame */
+	TArray<FPendingImpact> PendingImpacts;
+
+	/** A hitscan shot waiting for the batched trace pass */
+	struct FPendingHitscanShot
+	{
+		FVector TraceStart;
+		FVector TraceEnd;
+		double RewindTime;
+		int32 ArchetypeIndex;
+		TWeakObjectPtr<AActor> Owner;
+		TWeakObjectPtr<APawn> Instigator;
+		TWeakObjectPtr<AActor> Causer;
+		FTraceHandle Handle;
+	};
+
+	/** Hitscan shots fired this frame */
+	TArray<FPendingHitscanShot> PendingHitscanShots;
+
+	/** Hitscan shots traced last frame, waiting for their results */
+	TArray<FPendingHitscanShot> InFlightHitscanShots;
+
+	/** Number of rounds to reserve room for when the subsystem starts */
+	static constexpr int32 InitialRoundCapacity = 8192;
+
+	/** Distance a bounced round is pushed off the surface, so its next sweep doesn't start touching it */
+	static constexpr float BounceSkinWidth = 1.0f;
+
+public:
+
+	/**
+	 *  Fires a simulated round of the given projectile class. Server only. Returns false if the round was not fired
+	 *  If a rewind offset is given, the round hits characters at the positions they had that long before the current server time
+	 */
+	bool FireRound(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* ShotOwner, APawn* ShotInstigator, AActor* DamageCauser, uint32 ReplicationId = 0, float RewindOffset = 0.0f);
+
+	/**
+	 *  Queues a hitscan shot that uses the hit settings of the given projectile class. It will be traced with the rest of the frame's shots. Server only
+	 *  If a rewind time is given, characters are tested at the positions they had at that server time
+	 */
+	bool FireHitscan(TSubclassOf<AShooterProjectile> ProjectileClass, const FVector& TraceStart, const FVector& TraceEnd, AActor* ShotOwner, APawn* ShotInstigator, AActor* DamageCauser, double RewindTime = 0.0);
+
+	/** Returns the number of rounds currently in flight */
+	int32 GetNumRounds() const { return Positions.Num(); }
+
+	/** Subsystem initialization */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Subsystem cleanup */
+	virtual void Deinitialize() override;
+
+	/** Steps the simulation */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Stat id for the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/** Only simulate rounds in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Finds or builds the archetype for the given projectile class */
+	int32 FindOrAddArchetype(TSubclassOf<AShooterProjectile> ProjectileClass);
+
+	/** Moves every round forward and applies gravity */
+	void IntegrateRounds(float DeltaTime);
+
+	/** Issues an async sweep for every round from its previous to its current position */
+	void IssueSweeps();
+
+	/** Reads back last frame's sweeps and collects the hits */
+	void GatherSweepResults();
+
+	/** Bounces or resolves the hits collected by the sweep pass */
+	void ResolveImpacts();
+
+	/** Resolves the hit of a single round and flags it for removal */
+	void ResolveRoundHit(int32 RoundIndex, const FHitResult& Hit);
+
+	/** Issues an async trace for every hitscan shot fired this frame */
+	void IssueHitscanTraces();
+
+	/** Reads back last frame's hitscan traces and resolves the hits */
+	void ResolveHitscanShots();
+
+	/** Makes noise and applies damage for a hit, using the archetype settings */
+	void ApplyHit(const FShooterBallisticArchetype& Archetype, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, const FHitResult& Hit);
+
+	/** Removes every round flagged for removal */
+	void RemoveDeadRounds();
+
+	/** Removes a single round by swapping the last round into its place */
+	void RemoveRoundAtSwap(int32 RoundIndex);
+};
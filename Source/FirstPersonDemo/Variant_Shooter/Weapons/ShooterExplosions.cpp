@@ -0,0 +1,293 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterExplosions.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+#include "Engine/OverlapResult.h"
+#include "WorldCollision.h"
+#include "ShooterProjectileTimings.h"
+
+DECLARE_STATS_GROUP(TEXT("ShooterExplosions"), STATGROUP_ShooterExplosions, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Explosions Tick"), STAT_ExplosionsTick, STATGROUP_ShooterExplosions);
+DECLARE_CYCLE_STAT(TEXT("Gather Targets"), STAT_ExplosionsGather, STATGROUP_ShooterExplosions);
+DECLARE_CYCLE_STAT(TEXT("Apply Targets"), STAT_ExplosionsApply, STATGROUP_ShooterExplosions);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Queued Explosions"), STAT_ExplosionsQueued, STATGROUP_ShooterExplosions);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Overlap Queries"), STAT_ExplosionsQueries, STATGROUP_ShooterExplosions);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Targets"), STAT_ExplosionsTargets, STATGROUP_ShooterExplosions);
+
+/** Object types an explosion can catch */
+static FCollisionObjectQueryParams GetExplosionObjectParams()
+{
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+
+	return ObjectParams;
+}
+
+/** Query params for an explosion overlap. Skips the damage causer, and the shooter unless the explosion can hurt it */
+static FCollisionQueryParams GetExplosionQueryParams(const FShooterProjectileHitParams& Params, AActor* DamageCauser, APawn* ShotInstigator)
+{
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterExplosion), false);
+	QueryParams.AddIgnoredActor(DamageCauser);
+	if (!Params.bDamageOwner)
+	{
+		QueryParams.AddIgnoredActor(ShotInstigator);
+	}
+
+	return QueryParams;
+}
+
+void UShooterExplosionSubsystem::QueueExplosion(const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, const FVector& ExplosionCenter)
+{
+	// explosions are only resolved on the server
+	if (!DamageCauser || !DamageCauser->HasAuthority())
+	{
+		return;
+	}
+
+	FQueuedExplosion& Explosion = PendingExplosions.AddDefaulted_GetRef();
+	Explosion.Params = Params;
+	Explosion.Center = ExplosionCenter;
+	Explosion.DamageCauser = DamageCauser;
+	Explosion.ShotOwner = ShotOwner;
+	Explosion.ShotInstigator = ShotInstigator;
+}
+
+void UShooterExplosionSubsystem::ApplyExplosionImmediately(UWorld* World, const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, const FVector& ExplosionCenter)
+{
+	// explosions are only resolved on the server
+	if (!World || !DamageCauser || !DamageCauser->HasAuthority())
+	{
+		return;
+	}
+
+	TArray<FOverlapResult> Overlaps;
+	World->OverlapMultiByObjectType(Overlaps, ExplosionCenter, FQuat::Identity, GetExplosionObjectParams(), FCollisionShape::MakeSphere(Params.ExplosionRadius), GetExplosionQueryParams(Params, DamageCauser, ShotInstigator));
+
+	// overlaps return the same actor once per overlapped component. Only damage it once
+	TSet<const AActor*> DamagedActors;
+
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		AActor* Actor = Overlap.GetActor();
+
+		bool bAlreadyDamaged = false;
+		DamagedActors.Add(Actor, &bAlreadyDamaged);
+
+		if (!Actor || bAlreadyDamaged)
+		{
+			continue;
+		}
+
+		const FVector ToActor = Actor->GetActorLocation() - ExplosionCenter;
+
+		ApplyExplosionHit(Params, DamageCauser, ShotOwner, ShotInstigator, Actor, Overlap.GetComponent(), ExplosionCenter, ToActor.GetSafeNormal(), GetFalloffScale(Params, ToActor.Size()));
+	}
+}
+
+float UShooterExplosionSubsystem::GetFalloffScale(const FShooterProjectileHitParams& Params, float Distance)
+{
+	// full damage inside the inner radius
+	const float InnerRadius = FMath::Min(Params.ExplosionInnerRadius, Params.ExplosionRadius);
+	if (Distance <= InnerRadius || Params.ExplosionRadius <= InnerRadius)
+	{
+		return 1.0f;
+	}
+
+	// blend down to the min damage at the outer radius
+	const float Alpha = FMath::Clamp((Distance - InnerRadius) / (Params.ExplosionRadius - InnerRadius), 0.0f, 1.0f);
+	return FMath::Lerp(1.0f, Params.ExplosionMinDamageScale, FMath::Pow(Alpha, Params.ExplosionFalloff));
+}
+
+void UShooterExplosionSubsystem::ApplyExplosionHit(const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& ExplosionCenter, const FVector& Direction, float Scale)
+{
+	// scale the damage and impulse by the distance to the explosion
+	FShooterProjectileHitParams ScaledParams = Params;
+	ScaledParams.HitDamage *= Scale;
+	ScaledParams.PhysicsForce *= Scale;
+
+	AShooterProjectile::ApplyProjectileHit(ScaledParams, DamageCauser, ShotOwner, ShotInstigator, HitActor, HitComp, ExplosionCenter, Direction);
+}
+
+void UShooterExplosionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PendingExplosions.Reserve(64);
+	InFlightExplosions.Reserve(64);
+	ResolvedExplosions.Reserve(64);
+	Targets.Reserve(256);
+	CaughtActors.Reserve(64);
+}
+
+void UShooterExplosionSubsystem::Deinitialize()
+{
+	PendingExplosions.Empty();
+	InFlightExplosions.Empty();
+	ResolvedExplosions.Empty();
+	Targets.Empty();
+	CaughtActors.Empty();
+
+	SET_DWORD_STAT(STAT_ExplosionsQueued, 0);
+
+	Super::Deinitialize();
+}
+
+void UShooterExplosionSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (PendingExplosions.Num() == 0 && InFlightExplosions.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ExplosionsTick);
+
+	// queries issued last frame have finished by now
+	GatherFinishedQueries();
+
+	ApplyTargets();
+
+	IssueQueries();
+
+	SET_DWORD_STAT(STAT_ExplosionsQueued, GetNumQueuedExplosions());
+}
+
+TStatId UShooterExplosionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterExplosionSubsystem, STATGROUP_Tickables);
+}
+
+bool UShooterExplosionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterExplosionSubsystem::GatherFinishedQueries()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ExplosionsGather);
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Hit);
+
+	UWorld* World = GetWorld();
+
+	ResolvedExplosions.Reset();
+	Targets.Reset();
+
+	FOverlapDatum OverlapData;
+
+	for (int32 i = 0; i < InFlightExplosions.Num(); )
+	{
+		FQueuedExplosion& Explosion = InFlightExplosions[i];
+
+		if (World->QueryOverlapData(Explosion.QueryHandle, OverlapData))
+		{
+			// move the explosion to the resolved list so the targets can point at it
+			const int32 ExplosionIndex = ResolvedExplosions.Add(MoveTemp(Explosion));
+			GatherTargets(ExplosionIndex, OverlapData.OutOverlaps);
+
+		} else if (World->IsTraceHandleValid(Explosion.QueryHandle, true))
+		{
+			// still running
+			++i;
+			continue;
+		}
+
+		// finished or lost. Either way it no longer needs to wait
+		InFlightExplosions.RemoveAtSwap(i, 1, EAllowShrinking::No);
+	}
+}
+
+void UShooterExplosionSubsystem::GatherTargets(int32 ExplosionIndex, const TArray<FOverlapResult>& Overlaps)
+{
+	const FQueuedExplosion& Explosion = ResolvedExplosions[ExplosionIndex];
+
+	// overlaps return the same actor once per overlapped component. Only keep the first one
+	CaughtActors.Reset();
+
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		AActor* Actor = Overlap.GetActor();
+
+		bool bAlreadyCaught = false;
+		CaughtActors.Add(Actor, &bAlreadyCaught);
+
+		if (!Actor || bAlreadyCaught)
+		{
+			continue;
+		}
+
+		const FVector ToActor = Actor->GetActorLocation() - Explosion.Center;
+
+		FExplosionTarget& Target = Targets.AddDefaulted_GetRef();
+		Target.ExplosionIndex = ExplosionIndex;
+		Target.Actor = Actor;
+		Target.Component = Overlap.GetComponent();
+		Target.Direction = ToActor.GetSafeNormal();
+		Target.Scale = GetFalloffScale(Explosion.Params, ToActor.Size());
+	}
+}
+
+void UShooterExplosionSubsystem::ApplyTargets()
+{
+	if (Targets.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ExplosionsApply);
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Hit);
+
+	for (const FExplosionTarget& Target : Targets)
+	{
+		const FQueuedExplosion& Explosion = ResolvedExplosions[Target.ExplosionIndex];
+
+		// earlier targets in the batch may have killed this actor, or the weapon may be gone
+		AActor* DamageCauser = Explosion.DamageCauser.Get();
+		if (!DamageCauser || !IsValid(Target.Actor))
+		{
+			continue;
+		}
+
+		ApplyExplosionHit(Explosion.Params, DamageCauser, Explosion.ShotOwner.Get(), Explosion.ShotInstigator.Get(), Target.Actor, Target.Component, Explosion.Center, Target.Direction, Target.Scale);
+	}
+
+	INC_DWORD_STAT_BY(STAT_ExplosionsTargets, Targets.Num());
+
+	Targets.Reset();
+	ResolvedExplosions.Reset();
+}
+
+void UShooterExplosionSubsystem::IssueQueries()
+{
+	const int32 NumToIssue = FMath::Min(PendingExplosions.Num(), MaxQueriesPerFrame);
+	if (NumToIssue == 0)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	const FCollisionObjectQueryParams ObjectParams = GetExplosionObjectParams();
+
+	for (int32 i = 0; i < NumToIssue; ++i)
+	{
+		FQueuedExplosion& Explosion = PendingExplosions[i];
+
+		const FCollisionQueryParams QueryParams = GetExplosionQueryParams(Explosion.Params, Explosion.DamageCauser.Get(), Explosion.ShotInstigator.Get());
+
+		Explosion.QueryHandle = World->AsyncOverlapByObjectType(Explosion.Center, FQuat::Identity, ObjectParams, FCollisionShape::MakeSphere(Explosion.Params.ExplosionRadius), QueryParams);
+
+		InFlightExplosions.Add(MoveTemp(Explosion));
+	}
+
+	// explosions are queued in order, so the issued ones are always at the front
+	PendingExplosions.RemoveAt(0, NumToIssue, EAllowShrinking::No);
+
+	INC_DWORD_STAT_BY(STAT_ExplosionsQueries, NumToIssue);
+}
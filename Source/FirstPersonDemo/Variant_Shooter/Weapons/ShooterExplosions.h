@@ -0,0 +1,129 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "ShooterProjectile.h"
+#include "ShooterExplosions.generated.h"
+
+class APawn;
+class UPrimitiveComponent;
+
+/**
+ *  Resolves projectile explosions through async overlap queries
+ *  Explosions are queued during the frame and their overlaps are issued in a budgeted batch
+ *  The overlap results are read back on the next frame, deduplicated per explosion and applied in one pass
+ *  Only runs on the server
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UShooterExplosionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** An explosion waiting for its overlap query */
+	struct FQueuedExplosion
+	{
+		/** Damage, impulse and falloff settings */
+		FShooterProjectileHitParams Params;
+
+		/** Explosion center */
+		FVector Center = FVector::ZeroVector;
+
+		/** Actor reported as the damage causer */
+		TWeakObjectPtr<AActor> DamageCauser;
+
+		/** Actor that owns the shot, usually the character holding the weapon */
+		TWeakObjectPtr<AActor> ShotOwner;
+
+		/** Pawn that fired the shot */
+		TWeakObjectPtr<APawn> ShotInstigator;
+
+		/** Handle of the async overlap query. Invalid until the query is issued */
+		FTraceHandle QueryHandle;
+	};
+
+	/** An actor caught by an explosion, waiting for the batched damage pass */
+	struct FExplosionTarget
+	{
+		/** Index of the explosion in the resolved list */
+		int32 ExplosionIndex = INDEX_NONE;
+
+		/** Actor to damage */
+		AActor* Actor = nullptr;
+
+		/** First component of the actor found by the overlap */
+		UPrimitiveComponent* Component = nullptr;
+
+		/** Direction from the explosion center to the actor */
+		FVector Direction = FVector::ZeroVector;
+
+		/** Damage and impulse multiplier from the radial falloff */
+		float Scale = 1.0f;
+	};
+
+	/** Explosions waiting for their overlap query to be issued, oldest first */
+	TArray<FQueuedExplosion> PendingExplosions;
+
+	/** Explosions whose overlap query is running */
+	TArray<FQueuedExplosion> InFlightExplosions;
+
+	/** Explosions whose overlap results were read this frame */
+	TArray<FQueuedExplosion> ResolvedExplosions;
+
+	/** Actors caught by this frame's explosions */
+	TArray<FExplosionTarget> Targets;
+
+	/** Actors already caught by the explosion being gathered */
+	TSet<const AActor*> CaughtActors;
+
+	/** Max number of overlap queries issued per frame. Extra explosions wait for the next frame */
+	int32 MaxQueriesPerFrame = 32;
+
+public:
+
+	/** Queues an explosion to be resolved. Server only */
+	void QueueExplosion(const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, const FVector& ExplosionCenter);
+
+	/** Resolves an explosion right away with a blocking overlap. Used where there's no subsystem to queue it on. Server only */
+	static void ApplyExplosionImmediately(UWorld* World, const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, const FVector& ExplosionCenter);
+
+	/** Returns the number of explosions still waiting to be resolved */
+	int32 GetNumQueuedExplosions() const { return PendingExplosions.Num() + InFlightExplosions.Num(); }
+
+	/** Returns the damage and impulse multiplier for a target at the given distance from the explosion center */
+	static float GetFalloffScale(const FShooterProjectileHitParams& Params, float Distance);
+
+	/** Damages and pushes a single actor caught by an explosion, scaled by the falloff */
+	static void ApplyExplosionHit(const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& ExplosionCenter, const FVector& Direction, float Scale);
+
+	/** Subsystem initialization */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Subsystem cleanup */
+	virtual void Deinitialize() override;
+
+	/** Reads back the finished queries, applies their damage and issues the next batch */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Stat id for the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/** Only resolve explosions in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Reads the results of every finished overlap query and gathers the actors to damage */
+	void GatherFinishedQueries();
+
+	/** Collects the actors caught by a single explosion, once each */
+	void GatherTargets(int32 ExplosionIndex, const TArray<FOverlapResult>& Overlaps);
+
+	/** Applies damage and impulse to every gathered target */
+	void ApplyTargets();
+
+	/** Issues the overlap queries for as many pending explosions as the budget allows */
+	void IssueQueries();
+};
@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterImpactEffect.h"
+#include "ShooterProjectile.h"
+#include "ActorPoolSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Impact Effects"), STAT_LiveImpactEffects, STATGROUP_ShooterProjectiles);
+
+/** Name of the pool counter for impact effects currently playing */
+static const FName LiveImpactEffectsCounter(TEXT("ShooterImpactEffects"));
+
+AShooterImpactEffect::AShooterImpactEffect()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	// effects are purely local
+	bReplicates = false;
+
+	RootComponent = Root = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+AShooterImpactEffect* AShooterImpactEffect::SpawnImpactEffect(UWorld* World, TSubclassOf<AShooterImpactEffect> EffectClass, const FHitResult& Hit, APawn* EffectInstigator)
+{
+	// nobody is watching on a dedicated server
+	if (!World || !EffectClass || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return nullptr;
+	}
+
+	UActorPoolSubsystem* Pool = World->GetSubsystem<UActorPoolSubsystem>();
+	if (!Pool)
+	{
+		return nullptr;
+	}
+
+	// face the effect away from the impacted surface
+	const FTransform EffectTransform(Hit.ImpactNormal.Rotation(), Hit.ImpactPoint);
+
+	AShooterImpactEffect* Effect = Pool->Acquire<AShooterImpactEffect>(EffectClass, EffectTransform, nullptr, EffectInstigator);
+	if (Effect)
+	{
+		Effect->PlayImpact(Hit);
+	}
+
+	return Effect;
+}
+
+void AShooterImpactEffect::PlayImpact(const FHitResult& Hit)
+{
+	// pass control to BP to play the effects
+	BP_OnImpact(Hit);
+
+	// go back to the pool once the effects are done
+	if (EffectDuration > 0.0f)
+	{
+		GetWorld()->GetTimerManager().SetTimer(ReleaseTimer, this, &AShooterImpactEffect::OnEffectFinished, EffectDuration, false);
+
+	} else {
+
+		OnEffectFinished();
+	}
+}
+
+int32 AShooterImpactEffect::GetNumLiveEffects(const UWorld* World)
+{
+	const UActorPoolSubsystem* Pool = World ? World->GetSubsystem<UActorPoolSubsystem>() : nullptr;
+	return Pool ? Pool->GetLiveCount(LiveImpactEffectsCounter) : 0;
+}
+
+void AShooterImpactEffect::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetCountedAsLive(true);
+}
+
+void AShooterImpactEffect::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	GetWorld()->GetTimerManager().ClearTimer(ReleaseTimer);
+
+	SetCountedAsLive(false);
+}
+
+void AShooterImpactEffect::OnEffectFinished()
+{
+	UActorPoolSubsystem::ReleaseOrDestroy(this);
+}
+
+void AShooterImpactEffect::SetCountedAsLive(bool bLive)
+{
+	if (bCountedAsLive == bLive)
+	{
+		return;
+	}
+
+	bCountedAsLive = bLive;
+
+	// the counter lives on the world's pool, so each world counts its own effects
+	if (UActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+	{
+		const int32 NumLive = Pool->AddLiveCount(LiveImpactEffectsCounter, bLive ? 1 : -1);
+		SET_DWORD_STAT(STAT_LiveImpactEffects, NumLive);
+	}
+}
+
+void AShooterImpactEffect::OnAcquiredFromPool()
+{
+	SetCountedAsLive(true);
+}
+
+void AShooterImpactEffect::OnReturnedToPool()
+{
+	GetWorld()->GetTimerManager().ClearTimer(ReleaseTimer);
+
+	// let BP stop anything that's still playing
+	BP_OnImpactEffectReleased();
+
+	SetCountedAsLive(false);
+}
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "PoolableActor.h"
+#include "ShooterImpactEffect.generated.h"
+
+class USceneComponent;
+
+/**
+ *  Cheap, non-replicated proxy that plays the cosmetic effects of a projectile impact
+ *  Lets the projectile go back to the pool the instant it hits while the effects keep playing
+ *  Recycled through the UActorPoolSubsystem. Never spawned on dedicated servers
+ */
+UCLASS(abstract)
+class FIRSTPERSONDEMO_API AShooterImpactEffect : public AActor, public IPoolableActor
+{
+	GENERATED_BODY()
+
+	/** Root component to attach effects to */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	USceneComponent* Root;
+
+protected:
+
+	/** How long the effect plays before it goes back to the pool */
+	UPROPERTY(EditAnywhere, Category="Effect", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
+	float EffectDuration = 2.0f;
+
+	/** Timer that returns the effect to the pool */
+	FTimerHandle ReleaseTimer;
+
+	/** True while the effect counts towards the live effect stat */
+	bool bCountedAsLive = false;
+
+public:
+
+	/** Constructor */
+	AShooterImpactEffect();
+
+	/** Plays an impact effect of the given class at the hit location. Does nothing on dedicated servers */
+	static AShooterImpactEffect* SpawnImpactEffect(UWorld* World, TSubclassOf<AShooterImpactEffect> EffectClass, const FHitResult& Hit, APawn* EffectInstigator);
+
+	/** Starts playing the effect for the given hit */
+	void PlayImpact(const FHitResult& Hit);
+
+	/** Returns the number of impact effects currently playing in the given world */
+	static int32 GetNumLiveEffects(const UWorld* World);
+
+protected:
+
+	/** Gameplay initialization */
+	virtual void BeginPlay() override;
+
+	/** Gameplay cleanup */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+	/** Passes control to Blueprint to play the impact effects */
+	UFUNCTION(BlueprintImplementableEvent, Category="Effect", meta = (DisplayName = "On Impact"))
+	void BP_OnImpact(const FHitResult& Hit);
+
+	/** Passes control to Blueprint to stop any effects still playing when the proxy goes back to the pool */
+	UFUNCTION(BlueprintImplementableEvent, Category="Effect", meta = (DisplayName = "On Impact Effect Released"))
+	void BP_OnImpactEffectReleased();
+
+	/** Called from the release timer */
+	void OnEffectFinished();
+
+	/** Updates the live effect counter */
+	void SetCountedAsLive(bool bLive);
+
+public:
+
+	//~Begin IPoolableActor interface
+
+	/** Starts counting the effect as live again */
+	virtual void OnAcquiredFromPool() override;
+
+	/** Stops the effect and its release timer */
+	virtual void OnReturnedToPool() override;
+
+	//~End IPoolableActor interface
+};
@@ -7,6 +7,8 @@
 #include "Components/StaticMeshComponent.h"
 #include "ShooterWeaponHolder.h"
 #include "ShooterWeapon.h"
+#include "ShooterWeaponDefinition.h"
+#include "ShooterWeaponStreaming.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
 
@@ -42,10 +44,18 @@ void AShooterPickup::OnConstruction(const FTransform& Transform)
 {
 	Super::OnConstruction(Transform);
 
-	if (FWeaponTableRow* WeaponData = WeaponType.GetRow<FWeaponTableRow>(FString()))
+	// game worlds stream the mesh in on BeginPlay instead of stalling on it here
+	if (GetWorld() && GetWorld()->IsGameWorld())
 	{
-		// set the mesh
-		Mesh->SetStaticMesh(WeaponData->StaticMesh.LoadSynchronous());
+		return;
+	}
+
+	FShooterWeaponAssets Assets;
+
+	if (GetWeaponAssets(Assets))
+	{
+		// set the mesh so it shows in the editor
+		Mesh->SetStaticMesh(Assets.PickupMesh.LoadSynchronous());
 	}
 }
 
@@ -53,10 +63,49 @@ void AShooterPickup::BeginPlay()
 {
 	Super::BeginPlay();
 
-	if (FWeaponTableRow* WeaponData = WeaponType.GetRow<FWeaponTableRow>(FString()))
+	FShooterWeaponAssets Assets;
+
+	if (!GetWeaponAssets(Assets))
+	{
+		return;
+	}
+
+	// the assets were most likely preloaded already, in which case this calls back right away
+	if (UShooterWeaponStreamingSubsystem* Streaming = GetWorld()->GetSubsystem<UShooterWeaponStreamingSubsystem>())
+	{
+		WeaponAssetsHandle = Streaming->RequestWeaponAssets(Assets, FStreamableDelegate::CreateUObject(this, &AShooterPickup::OnWeaponAssetsLoaded));
+	}
+}
+
+bool AShooterPickup::GetWeaponAssets(FShooterWeaponAssets& OutAssets) const
+{
+	if (WeaponDefinition)
+	{
+		OutAssets.DefinitionId = WeaponDefinition->GetPrimaryAssetId();
+		OutAssets.PickupMesh = WeaponDefinition->PickupMesh;
+		OutAssets.WeaponClass = WeaponDefinition->WeaponClass;
+		return true;
+	}
+
+	if (const FWeaponTableRow* WeaponData = WeaponType.GetRow<FWeaponTableRow>(FString()))
+	{
+		OutAssets.PickupMesh = WeaponData->StaticMesh;
+		OutAssets.WeaponClass = WeaponData->WeaponToSpawn;
+		return true;
+	}
+
+	return false;
+}
+
+void AShooterPickup::OnWeaponAssetsLoaded()
+{
+	FShooterWeaponAssets Assets;
+
+	if (GetWeaponAssets(Assets))
 	{
-		// copy the weapon class
-		WeaponClass = WeaponData->WeaponToSpawn;
+		// set the mesh and copy the weapon class
+		Mesh->SetStaticMesh(Assets.PickupMesh.Get());
+		WeaponClass = Assets.WeaponClass.Get();
 	}
 }
 
@@ -66,6 +115,13 @@ void AShooterPickup::EndPlay(const EEndPlayReason::Type EndPlayReason)
 
 	// clear the respawn timer
 	GetWorld()->GetTimerManager().ClearTimer(RespawnTimer);
+
+	// let go of the weapon assets
+	if (WeaponAssetsHandle.IsValid())
+	{
+		WeaponAssetsHandle->CancelHandle();
+		WeaponAssetsHandle.Reset();
+	}
 }
 
 void AShooterPickup::OnOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
@@ -73,6 +129,17 @@ void AShooterPickup::OnOverlap(UPrimitiveComponent* OverlappedComponent, AActor*
 	// have we collided against a weapon holder?
 	if (IShooterWeaponHolder* WeaponHolder = Cast<IShooterWeaponHolder>(OtherActor))
 	{
+		// the weapon should have streamed in long before anyone could reach us. If it hasn't, load it now
+		if (!WeaponClass)
+		{
+			FShooterWeaponAssets Assets;
+
+			if (GetWeaponAssets(Assets))
+			{
+				WeaponClass = UShooterWeaponStreamingSubsystem::LoadSynchronous(Assets.WeaponClass, this);
+			}
+		}
+
 		WeaponHolder->AddWeaponClass(WeaponClass);
 
 		// hide this mesh
@@ -6,14 +6,18 @@
 #include "GameFramework/Actor.h"
 #include "Engine/DataTable.h"
 #include "Engine/StaticMesh.h"
+#include "Engine/StreamableManager.h"
 #include "ShooterPickup.generated.h"
 
 class USphereComponent;
 class UPrimitiveComponent;
 class AShooterWeapon;
+class UShooterWeaponDefinition;
+struct FShooterWeaponAssets;
 
 /**
  *  Holds information about a type of weapon pickup
+ *  Superseded by UShooterWeaponDefinition. References are soft so the table doesn't load every weapon with it
  */
 USTRUCT(BlueprintType)
 struct FWeaponTableRow : public FTableRowBase
@@ -26,7 +30,7 @@ struct FWeaponTableRow : public FTableRowBase
 
 	/** Weapon class to grant on pickup */
 	UPROPERTY(EditAnywhere)
-	TSubclassOf<AShooterWeapon> WeaponToSpawn;
+	TSoftClassPtr<AShooterWeapon> WeaponToSpawn;
 };
 
 /**
@@ -47,12 +51,19 @@ class FIRSTPERSONDEMO_API AShooterPickup : public AActor
 	
 protected:
 
-	/** Data on the type of picked weapon and visuals of this pickup */
+	/** Weapon granted by this pickup. Takes priority over the data table row */
+	UPROPERTY(EditAnywhere, Category="Pickup")
+	TObjectPtr<UShooterWeaponDefinition> WeaponDefinition;
+
+	/** Data on the type of picked weapon and visuals of this pickup. Only used if no weapon definition is set */
 	UPROPERTY(EditAnywhere, Category="Pickup")
 	FDataTableRowHandle WeaponType;
 
-	/** Type to weapon to grant on pickup. Set from the weapon data table. */
+	/** Type to weapon to grant on pickup. Set once the weapon assets have streamed in */
 	TSubclassOf<AShooterWeapon> WeaponClass;
+
+	/** Keeps the weapon assets in memory while this pickup is around */
+	TSharedPtr<FStreamableHandle> WeaponAssetsHandle;
 	
 	/** Time to wait before respawning this pickup */
 	UPROPERTY(EditAnywhere, Category="Pickup", meta = (ClampMin = 0, ClampMax = 120, Units = "s"))
@@ -66,6 +77,9 @@ public:
 	/** Constructor */
 	AShooterPickup();
 
+	/** Returns soft references to the mesh and weapon class of this pickup. Returns false if the pickup has no weapon set */
+	bool GetWeaponAssets(FShooterWeaponAssets& OutAssets) const;
+
 protected:
 
 	/** Native construction script */
@@ -83,6 +97,9 @@ protected:
 
 protected:
 
+	/** Sets the mesh and weapon class once the weapon assets have streamed in */
+	void OnWeaponAssetsLoaded();
+
 	/** Called when it's time to respawn this pickup */
 	void RespawnPickup();
 
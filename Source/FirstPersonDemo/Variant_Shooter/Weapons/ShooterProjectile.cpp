@@ -11,16 +11,31 @@
 #include "GameFramework/Pawn.h"
 #include "GameFramework/Controller.h"
 #include "TargetCube.h"
-#include "Engine/OverlapResult.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
+#include "ActorPoolSubsystem.h"
+#include "ShooterProjectileReplicator.h"
+#include "ShooterExplosions.h"
+#include "ShooterImpactEffect.h"
+#include "ShooterProjectileTimings.h"
+#include "ShooterNoise.h"
+#include "ShooterLagCompensation.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Projectiles"), STAT_LiveProjectiles, STATGROUP_ShooterProjectiles);
+
+/** Name of the pool counter for projectile actors currently out of the pool */
+static const FName LiveProjectilesCounter(TEXT("ShooterProjectiles"));
+
+double FShooterProjectileTimings::Seconds[(int32)EShooterProjectilePhase::Num] = {};
+FShooterProjectilePhaseScope* FShooterProjectilePhaseScope::Innermost = nullptr;
 
 AShooterProjectile::AShooterProjectile()
 {
 	PrimaryActorTick.bCanEverTick = true;
-	bReplicates = true;
 
-	SetReplicateMovement(true);
+	// clients simulate their own copy from the spawn event, so the actor itself doesn't replicate
+	bReplicates = false;
+	SetReplicateMovement(false);
 
 	// create the collision component and assign it as the root
 	RootComponent = CollisionComponent = CreateDefaultSubobject<USphereComponent>(TEXT("Collision Component"));
@@ -47,6 +62,14 @@ void AShooterProjectile::BeginPlay()
 	
 	// ignore the pawn that shot this projectile
 	CollisionComponent->IgnoreActorWhenMoving(GetInstigator(), true);
+
+	// remember how pawns block us, so it can be restored after a lag compensated shot
+	DefaultPawnResponse = CollisionComponent->GetCollisionResponseToChannel(ECC_Pawn);
+
+	// test the rewound characters after the movement component has moved us
+	AddTickPrerequisiteComponent(ProjectileMovement);
+
+	SetCountedAsLive(true);
 }
 
 void AShooterProjectile::EndPlay(EEndPlayReason::Type EndPlayReason)
@@ -55,6 +78,15 @@ void AShooterProjectile::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 	// clear the destruction timer
 	GetWorld()->GetTimerManager().ClearTimer(DestructionTimer);
+
+	SetCountedAsLive(false);
+}
+
+void AShooterProjectile::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	TraceRewoundStretch();
 }
 
 void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
@@ -65,90 +97,166 @@ void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Ot
 		return;
 	}
 
+	// a character that stood in front of this hit when the shooter fired takes it instead
+	FHitResult RewoundHit;
+	HandleImpact(FindRewoundHit(Hit.Location, RewoundHit) ? RewoundHit : Hit);
+}
+
+void AShooterProjectile::HandleImpact(const FHitResult& Hit)
+{
 	bHit = true;
 
 	// disable collision on the projectile
 	CollisionComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
-	// make AI perception noise
-	MakeNoise(NoiseLoudness, GetInstigator(), GetActorLocation(), NoiseRange, NoiseTag);
-
-	if (bExplodeOnHit)
+	// predicted copies only play their effects. The server copy deals the damage
+	if (!bCosmetic)
 	{
-		
-		// apply explosion damage centered on the projectile
-		ExplosionCheck(GetActorLocation());
+		SHOOTER_PROJECTILE_PHASE_SCOPE(Hit);
 
-	} else {
+		// make AI perception noise where the hit landed. A rewound hit lands short of where the projectile physically stopped
+		UShooterNoiseSubsystem::ReportNoise(this, NoiseLoudness, GetInstigator(), Hit.Location, NoiseRange, NoiseTag);
+
+		if (bExplodeOnHit)
+		{
+
+			// apply explosion damage centered on the hit
+			ExplosionCheck(Hit.Location);
+
+		} else {
 
-		// single hit projectile. Process the collided actor
-		ProcessHit(Other, OtherComp, Hit.ImpactPoint, -Hit.ImpactNormal);
+			// single hit projectile. Process the collided actor
+			ProcessHit(Hit.GetActor(), Hit.GetComponent(), Hit.ImpactPoint, -Hit.ImpactNormal);
 
+		}
+
+		// tell clients where their copy of this projectile should stop
+		if (AShooterProjectileReplicator* Replicator = AShooterProjectileReplicator::Get(GetWorld()))
+		{
+			Replicator->AddImpactEvent(ReplicationId, Hit.ImpactPoint, Hit.ImpactNormal);
+		}
 	}
 
-	// pass control to BP for any extra effects
-	BP_OnProjectileHit(Hit);
+	FinishHit(Hit);
+}
 
-	// check if we should schedule deferred destruction of the projectile
-	if (DeferredDestructionTime > 0.0f)
+bool AShooterProjectile::FindRewoundHit(const FVector& StretchEnd, FHitResult& OutHit) const
+{
+	if (RewindOffset <= 0.0f || bCosmetic)
 	{
-		GetWorld()->GetTimerManager().SetTimer(DestructionTimer, this, &AShooterProjectile::OnDeferredDestruction, DeferredDestructionTime, false);
+		return false;
+	}
 
-	} else {
+	UShooterLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UShooterLagCompensationSubsystem>();
+	if (!LagCompensation)
+	{
+		return false;
+	}
 
-		// destroy the projectile right away
-		Destroy();
+	// the shooter saw every target this far behind the server for the whole flight
+	FShooterRewoundHit RewoundHit;
+	if (!LagCompensation->TraceRewound(GetWorld()->GetTimeSeconds() - RewindOffset, LastRewindLocation, StretchEnd, GetInstigator(), RewoundHit, CollisionComponent->GetScaledSphereRadius()))
+	{
+		return false;
 	}
+
+	OutHit = RewoundHit.MakeHitResult();
+
+	return true;
 }
 
-void AShooterProjectile::ExplosionCheck(const FVector& ExplosionCenter)
+void AShooterProjectile::TraceRewoundStretch()
 {
+	if (RewindOffset <= 0.0f || bHit)
+	{
+		return;
+	}
 
-	// do a sphere overlap check look for nearby actors to damage
-	TArray<FOverlapResult> Overlaps;
+	FHitResult RewoundHit;
+	if (FindRewoundHit(GetActorLocation(), RewoundHit))
+	{
+		// stop the projectile on the rewound character
+		ProjectileMovement->StopMovementImmediately();
+		SetActorLocation(RewoundHit.Location, false, nullptr, ETeleportType::TeleportPhysics);
+
+		HandleImpact(RewoundHit);
+		return;
+	}
+
+	LastRewindLocation = GetActorLocation();
+}
+
+void AShooterProjectile::FinishHit(const FHitResult& Hit)
+{
+	// pass control to BP for any extra effects
+	BP_OnProjectileHit(Hit);
 
-	FCollisionShape OverlapShape;
-	OverlapShape.SetSphere(ExplosionRadius);
+	// hand the cosmetics over to a pooled proxy so the projectile can be recycled right away
+	if (ImpactEffectClass)
+	{
+		AShooterImpactEffect::SpawnImpactEffect(GetWorld(), ImpactEffectClass, Hit, GetInstigator());
 
-	FCollisionObjectQueryParams ObjectParams;
-	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
-	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
-	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+		ReleaseProjectile();
 
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
-	if (!bDamageOwner)
+	} else if (DeferredDestructionTime > 0.0f && (bCosmetic || GetNetMode() != NM_DedicatedServer))
 	{
-		QueryParams.AddIgnoredActor(GetInstigator());
+		// only copies someone is looking at need to linger. The authoritative one on a dedicated server already handed its impact to the replicator
+		GetWorld()->GetTimerManager().SetTimer(DestructionTimer, this, &AShooterProjectile::OnDeferredDestruction, DeferredDestructionTime, false);
+
+	} else {
+
+		// return the projectile to the pool right away
+		ReleaseProjectile();
 	}
+}
 
-	GetWorld()->OverlapMultiByObjectType(Overlaps, ExplosionCenter, FQuat::Identity, ObjectParams, OverlapShape, QueryParams);
+void AShooterProjectile::ExplosionCheck(const FVector& ExplosionCenter)
+{
+	ApplyProjectileExplosion(GetWorld(), GetHitParams(), this, GetOwner(), GetInstigator(), ExplosionCenter);
+}
 
-	TArray<AActor*> DamagedActors;
+FShooterProjectileHitParams AShooterProjectile::GetHitParams() const
+{
+	FShooterProjectileHitParams Params;
+	Params.PhysicsForce = PhysicsForce;
+	Params.HitDamage = HitDamage;
+	Params.HitDamageType = HitDamageType;
+	Params.bDamageOwner = bDamageOwner;
+	Params.bExplodeOnHit = bExplodeOnHit;
+	Params.ExplosionRadius = ExplosionRadius;
+	Params.ExplosionInnerRadius = ExplosionInnerRadius;
+	Params.ExplosionFalloff = ExplosionFalloff;
+	Params.ExplosionMinDamageScale = ExplosionMinDamageScale;
+	Params.NoiseLoudness = NoiseLoudness;
+	Params.NoiseRange = NoiseRange;
+	Params.NoiseTag = NoiseTag;
+
+	return Params;
+}
 
-	// process the overlap results
-	for (const FOverlapResult& CurrentOverlap : Overlaps)
+void AShooterProjectile::ApplyProjectileExplosion(UWorld* World, const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, const FVector& ExplosionCenter)
+{
+	// the overlap runs asynchronously and the damage is applied next frame with the rest of the frame's explosions
+	if (UShooterExplosionSubsystem* Explosions = World ? World->GetSubsystem<UShooterExplosionSubsystem>() : nullptr)
 	{
-		// overlaps may return the same actor multiple times per each component overlapped
-		// ensure we only damage each actor once by adding it to a damaged list
-		if (DamagedActors.Find(CurrentOverlap.GetActor()) == INDEX_NONE)
-		{
-			DamagedActors.Add(CurrentOverlap.GetActor());
+		Explosions->QueueExplosion(Params, DamageCauser, ShotOwner, ShotInstigator, ExplosionCenter);
 
-			// apply physics force away from the explosion
-			const FVector& ExplosionDir = CurrentOverlap.GetActor()->GetActorLocation() - GetActorLocation();
+	} else {
 
-			// push and/or damage the overlapped actor
-			ProcessHit(CurrentOverlap.GetActor(), CurrentOverlap.GetComponent(), GetActorLocation(), ExplosionDir.GetSafeNormal());
-		}
-			
+		// no subsystem in this world, so resolve it on the spot
+		UShooterExplosionSubsystem::ApplyExplosionImmediately(World, Params, DamageCauser, ShotOwner, ShotInstigator, ExplosionCenter);
 	}
 }
 
 void AShooterProjectile::ProcessHit(AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection)
+{
+	ApplyProjectileHit(GetHitParams(), this, GetOwner(), GetInstigator(), HitActor, HitComp, HitLocation, HitDirection);
+}
+
+void AShooterProjectile::ApplyProjectileHit(const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection)
 {
 	// ֻз˺
-	if (!HasAuthority())
+	if (!DamageCauser || !DamageCauser->HasAuthority())
 	{
 		return;
 	}
@@ -156,10 +264,10 @@ void AShooterProjectile::ProcessHit(AActor* HitActor, UPrimitiveComponent* HitCo
 	if (ACharacter* HitCharacter = Cast<ACharacter>(HitActor))
 	{
 		// ignore the owner of this projectile
-		if (HitCharacter != GetOwner() || bDamageOwner)
+		if (HitCharacter != ShotOwner || Params.bDamageOwner)
 		{
 			// Apply damage on the server
-			UGameplayStatics::ApplyDamage(HitCharacter, HitDamage, GetInstigator()->GetController(), this, HitDamageType);
+			UGameplayStatics::ApplyDamage(HitCharacter, Params.HitDamage, ShotInstigator ? ShotInstigator->GetController() : nullptr, DamageCauser, Params.HitDamageType);
 		}
 	}
 
@@ -167,19 +275,191 @@ void AShooterProjectile::ProcessHit(AActor* HitActor, UPrimitiveComponent* HitCo
 	if (ATargetCube* HitCube = Cast<ATargetCube>(HitActor))
 	{
 		// TargetCube Ѿͨ GameMode Ʒ
-		HitCube->OnProjectileHit(Cast<AShooterCharacter>(GetInstigator()));
+		HitCube->OnProjectileHit(Cast<AShooterCharacter>(ShotInstigator));
 	}
 
 	// have we hit a physics object?
-	if (HitComp->IsSimulatingPhysics() && !HitComp->IsA<ATargetCube>())
+	if (HitComp && HitComp->IsSimulatingPhysics() && !(HitActor && HitActor->IsA<ATargetCube>()))
 	{
 		// give some physics impulse to the object (server should apply physics impulses)
-		HitComp->AddImpulseAtLocation(HitDirection * PhysicsForce, HitLocation);
+		HitComp->AddImpulseAtLocation(HitDirection * Params.PhysicsForce, HitLocation);
 	}
 }
 
 void AShooterProjectile::OnDeferredDestruction()
 {
-	// destroy this actor
-	Destroy();
+	// return this actor to the pool
+	ReleaseProjectile();
+}
+
+void AShooterProjectile::ReleaseProjectile()
+{
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Release);
+
+	// projectiles aren't replicated, so every machine recycles its own copies
+	UActorPoolSubsystem::ReleaseOrDestroy(this);
+}
+
+void AShooterProjectile::ResetProjectile()
+{
+	// clear the hit state
+	bHit = false;
+
+	// re-enable collision and ignore the new shooter
+	CollisionComponent->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	CollisionComponent->ClearMoveIgnoreActors();
+	CollisionComponent->IgnoreActorWhenMoving(GetInstigator(), true);
+
+	// relaunch the projectile along its new facing
+	ProjectileMovement->SetUpdatedComponent(CollisionComponent);
+	ProjectileMovement->Velocity = GetActorForwardVector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->UpdateComponentVelocity();
+	ProjectileMovement->Activate(true);
+}
+
+void AShooterProjectile::InitializeShot(uint16 InShotId, bool bInCosmetic)
+{
+	ShotId = InShotId;
+	bCosmetic = bInCosmetic;
+}
+
+void AShooterProjectile::CatchUp(float DeltaTime)
+{
+	if (DeltaTime <= 0.0f || bHit || !ProjectileMovement->IsActive())
+	{
+		return;
+	}
+
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Movement);
+
+	// run the movement component by hand so the sweep still catches anything in the skipped stretch
+	ProjectileMovement->TickComponent(DeltaTime, LEVELTICK_All, nullptr);
+
+	TraceRewoundStretch();
+}
+
+void AShooterProjectile::SetRewindOffset(float Offset)
+{
+	RewindOffset = Offset;
+	LastRewindLocation = GetActorLocation();
+
+	// characters are hit at their rewound positions, so their present capsules shouldn't stop the projectile
+	CollisionComponent->SetCollisionResponseToChannel(ECC_Pawn, RewindOffset > 0.0f ? ECR_Ignore : DefaultPawnResponse.GetValue());
+}
+
+void AShooterProjectile::ReconcileTrajectory(const FVector& ServerOrigin, const FVector& ServerDirection, float FlightTime)
+{
+	// too late to correct a projectile that already hit something
+	if (bHit)
+	{
+		return;
+	}
+
+	// the movement component already applies the gravity scale, the same as it does while simulating
+	const FVector LaunchVelocity = ServerDirection * ProjectileMovement->InitialSpeed;
+	const FVector Gravity(0.0f, 0.0f, ProjectileMovement->GetGravityZ());
+
+	// extrapolate the server shot forward along its ballistic arc by the time our copy has already been flying
+	const FVector Location = ServerOrigin + LaunchVelocity * FlightTime + 0.5f * Gravity * FMath::Square(FlightTime);
+	const FVector Velocity = LaunchVelocity + Gravity * FlightTime;
+
+	SetFlightState(Location, Velocity);
+}
+
+void AShooterProjectile::SetFlightState(const FVector& Location, const FVector& Velocity)
+{
+	SetActorLocationAndRotation(Location, Velocity.Rotation(), false, nullptr, ETeleportType::TeleportPhysics);
+
+	ProjectileMovement->Velocity = Velocity;
+	ProjectileMovement->UpdateComponentVelocity();
+}
+
+void AShooterProjectile::PlayReplicatedImpact(const FVector& ImpactLocation, const FVector& ImpactNormal)
+{
+	// our copy may have already hit something on its own
+	if (bHit)
+	{
+		return;
+	}
+
+	bHit = true;
+
+	// stop exactly where the server projectile stopped
+	CollisionComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProjectileMovement->StopMovementImmediately();
+	SetActorLocation(ImpactLocation, false, nullptr, ETeleportType::TeleportPhysics);
+
+	FHitResult Hit(this, CollisionComponent, ImpactLocation, ImpactNormal);
+	Hit.ImpactPoint = ImpactLocation;
+	Hit.ImpactNormal = ImpactNormal;
+
+	FinishHit(Hit);
+}
+
+void AShooterProjectile::PlayReplicatedExpiry(const FVector& ExpiryLocation)
+{
+	// our copy may have already hit something on its own
+	if (bHit)
+	{
+		return;
+	}
+
+	bHit = true;
+
+	// nothing was hit, so there's nothing to show. Just recycle the copy
+	CollisionComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProjectileMovement->StopMovementImmediately();
+	SetActorLocation(ExpiryLocation, false, nullptr, ETeleportType::TeleportPhysics);
+
+	ReleaseProjectile();
+}
+
+int32 AShooterProjectile::GetNumLiveProjectiles(const UWorld* World)
+{
+	const UActorPoolSubsystem* Pool = World ? World->GetSubsystem<UActorPoolSubsystem>() : nullptr;
+	return Pool ? Pool->GetLiveCount(LiveProjectilesCounter) : 0;
+}
+
+void AShooterProjectile::SetCountedAsLive(bool bLive)
+{
+	if (bCountedAsLive == bLive)
+	{
+		return;
+	}
+
+	bCountedAsLive = bLive;
+
+	// the counter lives on the world's pool, so each world counts its own projectiles
+	if (UActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+	{
+		const int32 NumLive = Pool->AddLiveCount(LiveProjectilesCounter, bLive ? 1 : -1);
+		SET_DWORD_STAT(STAT_LiveProjectiles, NumLive);
+	}
+}
+
+void AShooterProjectile::OnAcquiredFromPool()
+{
+	ResetProjectile();
+
+	SetCountedAsLive(true);
+}
+
+void AShooterProjectile::OnReturnedToPool()
+{
+	// forget the last shot so a server copy never inherits the cosmetic flag
+	bCosmetic = false;
+	ShotId = 0;
+	ReplicationId = 0;
+	SetRewindOffset(0.0f);
+
+	// cancel any pending deferred destruction
+	GetWorld()->GetTimerManager().ClearTimer(DestructionTimer);
+
+	// stop moving and colliding while pooled
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+
+	CollisionComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	SetCountedAsLive(false);
 }
@@ -4,18 +4,84 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "PoolableActor.h"
 #include "ShooterProjectile.generated.h"
 
 class USphereComponent;
 class UProjectileMovementComponent;
 class ACharacter;
 class UPrimitiveComponent;
+class UDamageType;
+class AShooterImpactEffect;
+
+DECLARE_STATS_GROUP(TEXT("ShooterProjectiles"), STATGROUP_ShooterProjectiles, STATCAT_Advanced);
+
+/**
+ *  Damage, explosion and noise settings for a projectile hit
+ *  Shared between projectile actors and rounds simulated by the ballistics subsystem
+ */
+USTRUCT()
+struct FShooterProjectileHitParams
+{
+	GENERATED_BODY()
+
+	/** Physics force to apply on hit */
+	UPROPERTY()
+	float PhysicsForce = 100.0f;
+
+	/** Damage to apply on hit */
+	UPROPERTY()
+	float HitDamage = 25.0f;
+
+	/** Type of damage to apply */
+	UPROPERTY()
+	TSubclassOf<UDamageType> HitDamageType;
+
+	/** If true, the hit can damage the character that shot it */
+	UPROPERTY()
+	bool bDamageOwner = false;
+
+	/** If true, the hit applies radial damage to all actors in range */
+	UPROPERTY()
+	bool bExplodeOnHit = false;
+
+	/** Max distance for actors to be affected by explosion damage */
+	UPROPERTY()
+	float ExplosionRadius = 500.0f;
+
+	/** Distance from the explosion center that takes full damage */
+	UPROPERTY()
+	float ExplosionInnerRadius = 100.0f;
+
+	/** Exponent of the damage falloff between the inner and outer radius. 1 is linear */
+	UPROPERTY()
+	float ExplosionFalloff = 1.0f;
+
+	/** Fraction of the damage and impulse applied at the edge of the explosion */
+	UPROPERTY()
+	float ExplosionMinDamageScale = 1.0f;
+
+	/** Loudness of the AI perception noise done on hit */
+	UPROPERTY()
+	float NoiseLoudness = 3.0f;
+
+	/** Range of the AI perception noise done on hit */
+	UPROPERTY()
+	float NoiseRange = 3000.0f;
+
+	/** Tag of the AI perception noise done on hit */
+	UPROPERTY()
+	FName NoiseTag;
+};
 
 /**
  *  Simple projectile class for a first person shooter game
+ *  Recycled through the UActorPoolSubsystem instead of being destroyed
+ *  Impact cosmetics can be handed to a pooled AShooterImpactEffect so the projectile is recycled as soon as it hits
+ *  Never replicated as an actor. Clients simulate their own copy from AShooterProjectileReplicator spawn events
  */
 UCLASS(abstract)
-class FIRSTPERSONDEMO_API AShooterProjectile : public AActor
+class FIRSTPERSONDEMO_API AShooterProjectile : public AActor, public IPoolableActor
 {
 	GENERATED_BODY()
 	
@@ -65,16 +131,61 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 5000, Units = "cm"))
 	float ExplosionRadius = 500.0f;	
 
+	/** Distance from the explosion center that takes full damage and impulse */
+	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 5000, Units = "cm"))
+	float ExplosionInnerRadius = 100.0f;
+
+	/** Exponent of the damage and impulse falloff between the inner radius and the explosion radius. 1 is linear */
+	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0.1, ClampMax = 10))
+	float ExplosionFalloff = 1.0f;
+
+	/** Fraction of the damage and impulse applied at the edge of the explosion. Defaults to 1, which keeps full damage across the whole radius */
+	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 1))
+	float ExplosionMinDamageScale = 1.0f;
+
 	/** If true, this projectile has already hit another surface */
 	bool bHit = false;
 
-	/** How long to wait after a hit before destroying this projectile */
-	UPROPERTY(EditAnywhere, Category="Projectile|Destruction", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
+	/** Pooled proxy that plays the impact effects. If set, the projectile goes back to the pool the instant it hits */
+	UPROPERTY(EditAnywhere, Category="Projectile|Destruction")
+	TSubclassOf<AShooterImpactEffect> ImpactEffectClass;
+
+	/** How long to wait after a hit before destroying this projectile. Only used if there's no impact effect class. Dedicated servers release their copy right away */
+	UPROPERTY(EditAnywhere, Category="Projectile|Destruction", meta = (ClampMin = 0, ClampMax = 10, Units = "s", EditCondition = "ImpactEffectClass == nullptr"))
 	float DeferredDestructionTime = 5.0f;
 
+	/** Number of times a round simulated by the ballistics subsystem can bounce off non-pawn surfaces before it resolves its hit */
+	UPROPERTY(EditAnywhere, Category="Projectile|Simulation", meta = (ClampMin = 0, ClampMax = 10))
+	int32 MaxSimulatedBounces = 0;
+
+	/** Max flight time for a round simulated by the ballistics subsystem */
+	UPROPERTY(EditAnywhere, Category="Projectile|Simulation", meta = (ClampMin = 0, ClampMax = 60, Units = "s"))
+	float MaxSimulatedLifetime = 10.0f;
+
 	/** Timer to handle deferred destruction of this projectile */
 	FTimerHandle DestructionTimer;
 
+	/** If true, this is a client-side predicted copy. It never applies damage or makes noise */
+	bool bCosmetic = false;
+
+	/** Id of the weapon shot that launched this projectile. Used to match predicted and authoritative copies */
+	uint16 ShotId = 0;
+
+	/** Id of the spawn event that replicates this projectile. Zero if it isn't replicated */
+	uint32 ReplicationId = 0;
+
+	/** True while the projectile counts towards the live projectile stat */
+	bool bCountedAsLive = false;
+
+	/** How far behind the server the shooting client was seeing the world. Zero if the projectile isn't lag compensated. Server only */
+	float RewindOffset = 0.0f;
+
+	/** Where the last stretch tested against the rewound characters ended */
+	FVector LastRewindLocation = FVector::ZeroVector;
+
+	/** Response to pawns set up on the collision sphere. Lag compensated projectiles ignore pawns and test the rewound capsules instead */
+	TEnumAsByte<ECollisionResponse> DefaultPawnResponse = ECR_Block;
+
 public:	
 
 	/** Constructor */
@@ -88,11 +199,23 @@ protected:
 	/** Gameplay cleanup */
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
+	/** Tests the stretch flown this frame against the rewound characters */
+	virtual void Tick(float DeltaSeconds) override;
+
 	/** Handles collision */
 	virtual void NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit) override;
 
 protected:
 
+	/** Deals the damage for a hit, tells clients about it and plays the hit effects */
+	void HandleImpact(const FHitResult& Hit);
+
+	/** Returns true if the stretch from the last tested location to the given one hits a character at its rewound position */
+	bool FindRewoundHit(const FVector& StretchEnd, FHitResult& OutHit) const;
+
+	/** Resolves a hit on a rewound character along the stretch flown since the last test */
+	void TraceRewoundStretch();
+
 	/** Looks up actors within the explosion radius and damages them */
 	void ExplosionCheck(const FVector& ExplosionCenter);
 
@@ -106,4 +229,89 @@ protected:
 	/** Called from the destruction timer to destroy this projectile */
 	void OnDeferredDestruction();
 
+public:
+
+	/** Applies the damage and physics impulse for a single projectile hit on the given actor. Server only */
+	static void ApplyProjectileHit(const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection);
+
+	/** Queues an explosion that damages and pushes every actor within the explosion radius, scaled by the falloff. Server only */
+	static void ApplyProjectileExplosion(UWorld* World, const FShooterProjectileHitParams& Params, AActor* DamageCauser, AActor* ShotOwner, APawn* ShotInstigator, const FVector& ExplosionCenter);
+
+	/** Packs the hit settings for this projectile */
+	FShooterProjectileHitParams GetHitParams() const;
+
+	/** Returns the collision sphere */
+	USphereComponent* GetCollisionComponent() const { return CollisionComponent; }
+
+	/** Returns the projectile movement component */
+	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+	/** Returns the max bounces for simulated rounds */
+	int32 GetMaxSimulatedBounces() const { return MaxSimulatedBounces; }
+
+	/** Returns the max flight time for simulated rounds */
+	float GetMaxSimulatedLifetime() const { return MaxSimulatedLifetime; }
+
+	/** Tags this projectile with the shot that launched it. Cosmetic projectiles are local predictions that never deal damage */
+	void InitializeShot(uint16 InShotId, bool bInCosmetic);
+
+	/** Advances a freshly fired projectile by the part of the frame it was owed before it was spawned */
+	void CatchUp(float DeltaTime);
+
+	/** Resolves hits on characters at the positions the shooting client was seeing, the given time behind the server. Server only */
+	void SetRewindOffset(float Offset);
+
+	/** Moves a predicted projectile onto the trajectory the server actually fired, accounting for the time it has been flying */
+	void ReconcileTrajectory(const FVector& ServerOrigin, const FVector& ServerDirection, float FlightTime);
+
+	/** Returns the shot id */
+	uint16 GetShotId() const { return ShotId; }
+
+	/** Returns true if this is a client-side predicted copy */
+	bool IsCosmetic() const { return bCosmetic; }
+
+	/** Sets the id of the spawn event that replicates this projectile */
+	void SetReplicationId(uint32 InReplicationId) { ReplicationId = InReplicationId; }
+
+	/** Returns the id of the spawn event that replicates this projectile */
+	uint32 GetReplicationId() const { return ReplicationId; }
+
+	/** Teleports the projectile and sets its velocity. Used to place cosmetic copies on their simulated trajectory */
+	void SetFlightState(const FVector& Location, const FVector& Velocity);
+
+	/** Stops a cosmetic copy where the server said the projectile hit and plays the hit effects */
+	void PlayReplicatedImpact(const FVector& ImpactLocation, const FVector& ImpactNormal);
+
+	/** Stops a cosmetic copy whose server round ran out of flight time and recycles it without any hit effects */
+	void PlayReplicatedExpiry(const FVector& ExpiryLocation);
+
+	/** Returns the number of projectiles currently in flight or waiting on their deferred destruction in the given world */
+	static int32 GetNumLiveProjectiles(const UWorld* World);
+
+protected:
+
+	/** Returns this projectile to the pool, or destroys it if there's no pool */
+	void ReleaseProjectile();
+
+	/** Restores collision and movement so the projectile can be fired again */
+	void ResetProjectile();
+
+	/** Plays the hit effects and returns the projectile to the pool, right away or after the deferred destruction time */
+	void FinishHit(const FHitResult& Hit);
+
+	/** Updates the live projectile counter */
+	void SetCountedAsLive(bool bLive);
+
+public:
+
+	//~Begin IPoolableActor interface
+
+	/** Gets the projectile ready to fly again */
+	virtual void OnAcquiredFromPool() override;
+
+	/** Stops the projectile and clears any pending timers */
+	virtual void OnReturnedToPool() override;
+
+	//~End IPoolableActor interface
+
 };
@@ -0,0 +1,347 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterProjectileReplicator.h"
+#include "ShooterProjectile.h"
+#include "ShooterWeapon.h"
+#include "ShooterGameState.h"
+#include "ActorPoolSubsystem.h"
+#include "ShooterProjectileTimings.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Engine/PackageMapClient.h"
+#include "Engine/NetConnection.h"
+
+void FShooterProjectileSpawnEvent::PostReplicatedAdd(const FShooterProjectileSpawnArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->HandleSpawnEvent(*this);
+	}
+}
+
+bool FShooterProjectileSpawnArray::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	// remember who we're writing for, so ShouldWriteFastArrayItem can skip the shooter's own events
+	UPackageMapClient* PackageMap = Cast<UPackageMapClient>(DeltaParms.Map);
+	TGuardValue<const UNetConnection*> ConnectionGuard(WritingConnection, PackageMap ? PackageMap->GetConnection() : nullptr);
+
+	return FFastArraySerializer::FastArrayDeltaSerialize<FShooterProjectileSpawnEvent, FShooterProjectileSpawnArray>(Items, DeltaParms, *this);
+}
+
+bool FShooterProjectileSpawnArray::IsShooterConnection(const FShooterProjectileSpawnEvent& Event) const
+{
+	return WritingConnection && Event.ShotInstigator && Event.ShotInstigator->GetNetConnection() == WritingConnection;
+}
+
+void FShooterProjectileImpactEvent::PostReplicatedAdd(const FShooterProjectileImpactArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->HandleImpactEvent(*this);
+	}
+}
+
+void FShooterHitscanTracerEvent::PostReplicatedAdd(const FShooterHitscanTracerArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->HandleTracerEvent(*this);
+	}
+}
+
+AShooterProjectileReplicator::AShooterProjectileReplicator()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickInterval = 0.25f;
+
+	bReplicates = true;
+	bAlwaysRelevant = true;
+
+	// events are small, so send them as soon as possible
+	SetNetUpdateFrequency(60.0f);
+}
+
+AShooterProjectileReplicator* AShooterProjectileReplicator::Get(const UWorld* World)
+{
+	const AShooterGameState* GameState = World ? World->GetGameState<AShooterGameState>() : nullptr;
+	return GameState ? GameState->GetProjectileReplicator() : nullptr;
+}
+
+uint32 AShooterProjectileReplicator::AddSpawnEvent(TSubclassOf<AShooterProjectile> ProjectileClass, APawn* ShotInstigator, const FTransform& LaunchTransform, int32 Seed)
+{
+	if (!ProjectileClass || !HasAuthority())
+	{
+		return 0;
+	}
+
+	// skip zero so it can mean "not replicated"
+	if (++LastProjectileId == 0)
+	{
+		++LastProjectileId;
+	}
+
+	const UProjectileMovementComponent* Movement = ProjectileClass->GetDefaultObject<AShooterProjectile>()->GetProjectileMovement();
+
+	// the tick only prunes a few times a second, so hold the cap here
+	if (MakeRoomForEvent(SpawnEvents.Items))
+	{
+		SpawnEvents.MarkArrayDirty();
+	}
+
+	FShooterProjectileSpawnEvent& Event = SpawnEvents.Items.AddDefaulted_GetRef();
+	Event.ProjectileId = LastProjectileId;
+	Event.ProjectileClass = ProjectileClass;
+	Event.ShotInstigator = ShotInstigator;
+	Event.Origin = LaunchTransform.GetLocation();
+	Event.Direction = LaunchTransform.GetRotation().GetForwardVector();
+	Event.Speed = Movement ? Movement->InitialSpeed : 0.0f;
+	Event.Seed = Seed;
+	Event.ServerTime = GetWorld()->GetTimeSeconds();
+
+	SpawnEvents.MarkItemDirty(Event);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterProjectileReplicator, SpawnEvents, this);
+
+	return LastProjectileId;
+}
+
+void AShooterProjectileReplicator::AddImpactEvent(uint32 ProjectileId, const FVector& Location, const FVector& Normal)
+{
+	if (ProjectileId == 0 || !HasAuthority())
+	{
+		return;
+	}
+
+	if (MakeRoomForEvent(ImpactEvents.Items))
+	{
+		ImpactEvents.MarkArrayDirty();
+	}
+
+	FShooterProjectileImpactEvent& Event = ImpactEvents.Items.AddDefaulted_GetRef();
+	Event.ProjectileId = ProjectileId;
+	Event.Location = Location;
+	Event.Normal = Normal;
+	Event.ServerTime = GetWorld()->GetTimeSeconds();
+
+	ImpactEvents.MarkItemDirty(Event);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterProjectileReplicator, ImpactEvents, this);
+}
+
+void AShooterProjectileReplicator::AddExpiryEvent(uint32 ProjectileId, const FVector& Location)
+{
+	if (ProjectileId == 0 || !HasAuthority())
+	{
+		return;
+	}
+
+	if (MakeRoomForEvent(ImpactEvents.Items))
+	{
+		ImpactEvents.MarkArrayDirty();
+	}
+
+	// expiries ride on the impact array, so the copy is looked up and stopped the same way
+	FShooterProjectileImpactEvent& Event = ImpactEvents.Items.AddDefaulted_GetRef();
+	Event.ProjectileId = ProjectileId;
+	Event.Location = Location;
+	Event.bExpired = true;
+	Event.ServerTime = GetWorld()->GetTimeSeconds();
+
+	ImpactEvents.MarkItemDirty(Event);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterProjectileReplicator, ImpactEvents, this);
+}
+
+void AShooterProjectileReplicator::AddTracerEvent(AShooterWeapon* Weapon, const FVector& TraceStart, const FVector& TraceEnd)
+{
+	if (!Weapon || !HasAuthority())
+	{
+		return;
+	}
+
+	if (MakeRoomForEvent(TracerEvents.Items))
+	{
+		TracerEvents.MarkArrayDirty();
+	}
+
+	FShooterHitscanTracerEvent& Event = TracerEvents.Items.AddDefaulted_GetRef();
+	Event.Weapon = Weapon;
+	Event.TraceStart = TraceStart;
+	Event.TraceEnd = TraceEnd;
+	Event.ServerTime = GetWorld()->GetTimeSeconds();
+
+	TracerEvents.MarkItemDirty(Event);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterProjectileReplicator, TracerEvents, this);
+
+	// events are never added back on the server, so a listen server draws its own copy here
+	Weapon->PlayReplicatedTracer(TraceStart, TraceEnd);
+}
+
+void AShooterProjectileReplicator::HandleSpawnEvent(const FShooterProjectileSpawnEvent& Event)
+{
+	// the server already has the real projectile. The shooting client never gets its own events, but replays may still carry them
+	if (HasAuthority() || !Event.ProjectileClass || (Event.ShotInstigator && Event.ShotInstigator->IsLocallyControlled()))
+	{
+		return;
+	}
+
+	// work out how long the projectile has already been flying
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float ServerNow = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	const float FlightTime = FMath::Max(ServerNow - Event.ServerTime, 0.0f);
+
+	// too old to be worth showing
+	if (FlightTime > SpawnEventLifetime)
+	{
+		return;
+	}
+
+	// extrapolate the launch state along the ballistic arc
+	const AShooterProjectile* ProjectileCDO = Event.ProjectileClass->GetDefaultObject<AShooterProjectile>();
+	const float GravityScale = ProjectileCDO->GetProjectileMovement() ? ProjectileCDO->GetProjectileMovement()->ProjectileGravityScale : 1.0f;
+	const FVector Gravity(0.0f, 0.0f, GetWorld()->GetGravityZ() * GravityScale);
+
+	const FVector LaunchVelocity = FVector(Event.Direction) * Event.Speed;
+	const FVector Location = FVector(Event.Origin) + LaunchVelocity * FlightTime + 0.5f * Gravity * FMath::Square(FlightTime);
+	const FVector Velocity = LaunchVelocity + Gravity * FlightTime;
+
+	SHOOTER_PROJECTILE_PHASE_SCOPE(Spawn);
+
+	UActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+	AShooterProjectile* Projectile = Pool ? Pool->Acquire<AShooterProjectile>(Event.ProjectileClass, FTransform(Velocity.Rotation(), Location), nullptr, Event.ShotInstigator) : nullptr;
+
+	if (Projectile)
+	{
+		Projectile->InitializeShot(0, true);
+		Projectile->SetReplicationId(Event.ProjectileId);
+		Projectile->SetFlightState(Location, Velocity);
+
+		ClientProjectiles.Add(Event.ProjectileId, Projectile);
+	}
+}
+
+void AShooterProjectileReplicator::HandleImpactEvent(const FShooterProjectileImpactEvent& Event)
+{
+	TWeakObjectPtr<AShooterProjectile> Projectile;
+	if (!ClientProjectiles.RemoveAndCopyValue(Event.ProjectileId, Projectile))
+	{
+		return;
+	}
+
+	// the pooled projectile may have been reused by another event in the meantime
+	if (!Projectile.IsValid() || Projectile->GetReplicationId() != Event.ProjectileId)
+	{
+		return;
+	}
+
+	if (Event.bExpired)
+	{
+		Projectile->PlayReplicatedExpiry(Event.Location);
+
+	} else {
+
+		Projectile->PlayReplicatedImpact(Event.Location, Event.Normal);
+	}
+}
+
+void AShooterProjectileReplicator::HandleTracerEvent(const FShooterHitscanTracerEvent& Event)
+{
+	// the weapon may not be relevant to this client
+	if (Event.Weapon)
+	{
+		Event.Weapon->PlayReplicatedTracer(Event.TraceStart, Event.TraceEnd);
+	}
+}
+
+void AShooterProjectileReplicator::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	SpawnEvents.Owner = this;
+	ImpactEvents.Owner = this;
+	TracerEvents.Owner = this;
+}
+
+void AShooterProjectileReplicator::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	if (HasAuthority())
+	{
+		// old events are no use to anyone
+		if (PruneEvents(SpawnEvents.Items, Now - SpawnEventLifetime))
+		{
+			SpawnEvents.MarkArrayDirty();
+			MARK_PROPERTY_DIRTY_FROM_NAME(AShooterProjectileReplicator, SpawnEvents, this);
+		}
+
+		if (PruneEvents(ImpactEvents.Items, Now - ImpactEventLifetime))
+		{
+			ImpactEvents.MarkArrayDirty();
+			MARK_PROPERTY_DIRTY_FROM_NAME(AShooterProjectileReplicator, ImpactEvents, this);
+		}
+
+		if (PruneEvents(TracerEvents.Items, Now - TracerEventLifetime))
+		{
+			TracerEvents.MarkArrayDirty();
+			MARK_PROPERTY_DIRTY_FROM_NAME(AShooterProjectileReplicator, TracerEvents, this);
+		}
+	}
+
+	// forget cosmetic projectiles that were recycled without an impact event
+	for (auto It = ClientProjectiles.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid() || It.Value()->GetReplicationId() != It.Key())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+template<typename ItemType>
+bool AShooterProjectileReplicator::PruneEvents(TArray<ItemType>& Items, float OldestTime) const
+{
+	// events are added in order, so the old ones are always at the front
+	int32 NumToRemove = 0;
+	while (NumToRemove < Items.Num() && (Items[NumToRemove].ServerTime < OldestTime || Items.Num() - NumToRemove > MaxEvents))
+	{
+		++NumToRemove;
+	}
+
+	if (NumToRemove > 0)
+	{
+		Items.RemoveAt(0, NumToRemove, EAllowShrinking::No);
+		return true;
+	}
+
+	return false;
+}
+
+template<typename ItemType>
+bool AShooterProjectileReplicator::MakeRoomForEvent(TArray<ItemType>& Items) const
+{
+	const int32 NumToRemove = Items.Num() - MaxEvents + 1;
+
+	if (NumToRemove > 0)
+	{
+		Items.RemoveAt(0, NumToRemove, EAllowShrinking::No);
+		return true;
+	}
+
+	return false;
+}
+
+void AShooterProjectileReplicator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterProjectileReplicator, SpawnEvents, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterProjectileReplicator, ImpactEvents, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterProjectileReplicator, TracerEvents, Params);
+}
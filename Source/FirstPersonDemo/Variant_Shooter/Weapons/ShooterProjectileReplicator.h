@@ -0,0 +1,325 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "ShooterProjectileReplicator.generated.h"
+
+class AShooterProjectile;
+class AShooterProjectileReplicator;
+class AShooterWeapon;
+class APawn;
+class UNetConnection;
+struct FShooterProjectileSpawnArray;
+struct FShooterProjectileImpactArray;
+struct FShooterHitscanTracerArray;
+
+/**
+ *  Everything a client needs to simulate a projectile on its own
+ */
+USTRUCT()
+struct FShooterProjectileSpawnEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Server assigned id, used to match impact events */
+	UPROPERTY()
+	uint32 ProjectileId = 0;
+
+	/** Projectile class to simulate */
+	UPROPERTY()
+	TSubclassOf<AShooterProjectile> ProjectileClass;
+
+	/** Pawn that fired the projectile. Its own client is already showing a predicted copy */
+	UPROPERTY()
+	TObjectPtr<APawn> ShotInstigator;
+
+	/** Launch location */
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	/** Launch direction */
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction;
+
+	/** Launch speed */
+	UPROPERTY()
+	float Speed = 0.0f;
+
+	/** Seed of the random stream used for the shot spread. Derived from the weapon seed and shot id, see AShooterWeapon::GetShotStream */
+	UPROPERTY()
+	int32 Seed = 0;
+
+	/** Server time the projectile was launched at */
+	UPROPERTY()
+	float ServerTime = 0.0f;
+
+	/** Spawns the cosmetic copy on clients */
+	void PostReplicatedAdd(const FShooterProjectileSpawnArray& InArraySerializer);
+};
+
+/**
+ *  Fast array of recent projectile spawn events
+ */
+USTRUCT()
+struct FShooterProjectileSpawnArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Recent spawn events */
+	UPROPERTY()
+	TArray<FShooterProjectileSpawnEvent> Items;
+
+	/** Actor that owns this array */
+	AShooterProjectileReplicator* Owner = nullptr;
+
+	/** Connection the array is being written for. Only set while the server serializes it */
+	const UNetConnection* WritingConnection = nullptr;
+
+	/** Serializes the array for a single connection */
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+	/** The shooting client already shows its predicted copy, so its own spawn events are never sent to it */
+	template<typename Type, typename SerializerType>
+	bool ShouldWriteFastArrayItem(const Type& Item, const bool bIsWritingOnClient)
+	{
+		if (bIsWritingOnClient)
+		{
+			return Item.ReplicationID != INDEX_NONE;
+		}
+
+		return !IsShooterConnection(Item);
+	}
+
+	/** Returns true if the event's instigator is controlled through the connection being written */
+	bool IsShooterConnection(const FShooterProjectileSpawnEvent& Event) const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterProjectileSpawnArray> : public TStructOpsTypeTraitsBase2<FShooterProjectileSpawnArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ *  Tells clients where a projectile hit
+ */
+USTRUCT()
+struct FShooterProjectileImpactEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Id of the projectile that hit */
+	UPROPERTY()
+	uint32 ProjectileId = 0;
+
+	/** Impact location */
+	UPROPERTY()
+	FVector_NetQuantize10 Location;
+
+	/** Impact surface normal */
+	UPROPERTY()
+	FVector_NetQuantizeNormal Normal;
+
+	/** True if the projectile ran out of flight time instead of hitting something. The copy stops without hit effects */
+	UPROPERTY()
+	bool bExpired = false;
+
+	/** Server time the impact happened at. Only used to drop old events */
+	UPROPERTY(NotReplicated)
+	float ServerTime = 0.0f;
+
+	/** Stops the cosmetic copy on clients */
+	void PostReplicatedAdd(const FShooterProjectileImpactArray& InArraySerializer);
+};
+
+/**
+ *  Fast array of recent projectile impact events
+ */
+USTRUCT()
+struct FShooterProjectileImpactArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Recent impact events */
+	UPROPERTY()
+	TArray<FShooterProjectileImpactEvent> Items;
+
+	/** Actor that owns this array */
+	AShooterProjectileReplicator* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FShooterProjectileImpactEvent, FShooterProjectileImpactArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterProjectileImpactArray> : public TStructOpsTypeTraitsBase2<FShooterProjectileImpactArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ *  Tells clients to draw the tracer of a hitscan shot
+ */
+USTRUCT()
+struct FShooterHitscanTracerEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Weapon that fired the shot */
+	UPROPERTY()
+	TObjectPtr<AShooterWeapon> Weapon;
+
+	/** Trace start */
+	UPROPERTY()
+	FVector_NetQuantize TraceStart;
+
+	/** Trace end */
+	UPROPERTY()
+	FVector_NetQuantize TraceEnd;
+
+	/** Server time the shot was fired at. Only used to drop old events */
+	UPROPERTY(NotReplicated)
+	float ServerTime = 0.0f;
+
+	/** Draws the tracer on clients */
+	void PostReplicatedAdd(const FShooterHitscanTracerArray& InArraySerializer);
+};
+
+/**
+ *  Fast array of recent hitscan tracer events
+ */
+USTRUCT()
+struct FShooterHitscanTracerArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Recent tracer events */
+	UPROPERTY()
+	TArray<FShooterHitscanTracerEvent> Items;
+
+	/** Actor that owns this array */
+	AShooterProjectileReplicator* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FShooterHitscanTracerEvent, FShooterHitscanTracerArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterHitscanTracerArray> : public TStructOpsTypeTraitsBase2<FShooterHitscanTracerArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ *  World level manager that replicates projectiles as compact spawn and impact events
+ *  Projectile actors are never replicated themselves. Clients simulate their own cosmetic copy from the spawn event
+ *  Hitscan tracers ride along as a third event array, so a burst of shots costs one delta update instead of one RPC per shot
+ *  Spawned by the shooter game state on the server
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API AShooterProjectileReplicator : public AInfo
+{
+	GENERATED_BODY()
+
+	/** Recent spawn events */
+	UPROPERTY(Replicated)
+	FShooterProjectileSpawnArray SpawnEvents;
+
+	/** Recent impact events */
+	UPROPERTY(Replicated)
+	FShooterProjectileImpactArray ImpactEvents;
+
+	/** Recent hitscan tracer events */
+	UPROPERTY(Replicated)
+	FShooterHitscanTracerArray TracerEvents;
+
+	/** Cosmetic projectiles spawned on this client, by projectile id */
+	TMap<uint32, TWeakObjectPtr<AShooterProjectile>> ClientProjectiles;
+
+	/** Last projectile id handed out by the server */
+	uint32 LastProjectileId = 0;
+
+protected:
+
+	/** Time spawn events are kept around so late joiners and newly relevant clients can still see the projectile */
+	UPROPERTY(EditAnywhere, Category="Replication", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
+	float SpawnEventLifetime = 1.0f;
+
+	/** Time impact events are kept around */
+	UPROPERTY(EditAnywhere, Category="Replication", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
+	float ImpactEventLifetime = 0.5f;
+
+	/** Time tracer events are kept around. Kept short so newly relevant clients don't draw stale tracers */
+	UPROPERTY(EditAnywhere, Category="Replication", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
+	float TracerEventLifetime = 0.25f;
+
+	/** Max number of events of each kind kept at once. The oldest ones are dropped first */
+	UPROPERTY(EditAnywhere, Category="Replication", meta = (ClampMin = 1, ClampMax = 1000))
+	int32 MaxEvents = 256;
+
+public:
+
+	/** Constructor */
+	AShooterProjectileReplicator();
+
+	/** Returns the replicator for the given world, if the game state has one */
+	static AShooterProjectileReplicator* Get(const UWorld* World);
+
+	/** Records a projectile launch for clients to simulate. Server only. Returns the projectile id to use for the impact event */
+	uint32 AddSpawnEvent(TSubclassOf<AShooterProjectile> ProjectileClass, APawn* ShotInstigator, const FTransform& LaunchTransform, int32 Seed);
+
+	/** Records a projectile impact. Server only */
+	void AddImpactEvent(uint32 ProjectileId, const FVector& Location, const FVector& Normal);
+
+	/** Records a projectile that ran out of flight time without hitting anything. Server only */
+	void AddExpiryEvent(uint32 ProjectileId, const FVector& Location);
+
+	/** Records a hitscan shot for clients to draw its tracer. Server only. Also draws it here if this server renders */
+	void AddTracerEvent(AShooterWeapon* Weapon, const FVector& TraceStart, const FVector& TraceEnd);
+
+	/** Spawns the cosmetic copy of a projectile on this client */
+	void HandleSpawnEvent(const FShooterProjectileSpawnEvent& Event);
+
+	/** Stops the cosmetic copy of a projectile on this client */
+	void HandleImpactEvent(const FShooterProjectileImpactEvent& Event);
+
+	/** Draws a hitscan tracer on this client */
+	void HandleTracerEvent(const FShooterHitscanTracerEvent& Event);
+
+protected:
+
+	/** Gameplay initialization */
+	virtual void PostInitializeComponents() override;
+
+	/** Drops old events on the server */
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Drops events older than the given time, or over the max count. Returns true if any event was dropped */
+	template<typename ItemType>
+	bool PruneEvents(TArray<ItemType>& Items, float OldestTime) const;
+
+	/** Drops the oldest events so one more fits under the max count. Returns true if any event was dropped */
+	template<typename ItemType>
+	bool MakeRoomForEvent(TArray<ItemType>& Items) const;
+
+public:
+
+	/** Replication list */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+};
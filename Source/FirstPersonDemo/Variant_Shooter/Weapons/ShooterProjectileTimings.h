@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+/**
+ *  Phases of a projectile's life measured for benchmarking
+ */
+enum class EShooterProjectilePhase : uint8
+{
+	/** Handing out projectiles and rounds */
+	Spawn,
+
+	/** Moving and sweeping projectiles and rounds */
+	Movement,
+
+	/** Damage, impulse and explosion processing */
+	Hit,
+
+	/** Returning projectiles to the pool and removing rounds */
+	Release,
+
+	Num
+};
+
+/**
+ *  Game thread time spent in each projectile phase since the last reset
+ *  Times are exclusive. A phase that starts inside another one pauses it, so nested work, like a release during a hit, is only counted once
+ *  Read and reset once per frame by the projectile benchmark
+ */
+struct FIRSTPERSONDEMO_API FShooterProjectileTimings
+{
+	/** Accumulated seconds per phase */
+	static double Seconds[(int32)EShooterProjectilePhase::Num];
+
+	/** Returns the accumulated time for a phase, in milliseconds */
+	static double GetMilliseconds(EShooterProjectilePhase Phase) { return Seconds[(int32)Phase] * 1000.0; }
+
+	/** Clears every phase */
+	static void Reset() { FMemory::Memzero(Seconds); }
+};
+
+/**
+ *  Adds the time spent inside its scope to a projectile phase, minus the time spent in scopes nested inside it
+ *  Only used on the game thread
+ */
+struct FShooterProjectilePhaseScope
+{
+	explicit FShooterProjectilePhaseScope(EShooterProjectilePhase InPhase)
+		: Phase(InPhase)
+		, Parent(Innermost)
+	{
+		StartTime = FPlatformTime::Seconds();
+
+		// pause the enclosing phase until this one ends
+		if (Parent)
+		{
+			Parent->AddElapsed(StartTime);
+		}
+
+		Innermost = this;
+	}
+
+	~FShooterProjectilePhaseScope()
+	{
+		const double Now = FPlatformTime::Seconds();
+		AddElapsed(Now);
+
+		// resume the enclosing phase
+		Innermost = Parent;
+
+		if (Parent)
+		{
+			Parent->StartTime = Now;
+		}
+	}
+
+private:
+
+	/** Adds the time since the scope started or was resumed to its phase */
+	void AddElapsed(double Now) const
+	{
+		FShooterProjectileTimings::Seconds[(int32)Phase] += Now - StartTime;
+	}
+
+	/** Innermost scope currently open */
+	static FShooterProjectilePhaseScope* Innermost;
+
+	EShooterProjectilePhase Phase;
+	FShooterProjectilePhaseScope* Parent;
+	double StartTime;
+};
+
+#if !UE_BUILD_SHIPPING
+	#define SHOOTER_PROJECTILE_PHASE_SCOPE(Phase) FShooterProjectilePhaseScope ANONYMOUS_VARIABLE(ProjectilePhase_)(EShooterProjectilePhase::Phase)
+#else
+	#define SHOOTER_PROJECTILE_PHASE_SCOPE(Phase)
+#endif
@@ -11,10 +11,25 @@
 #include "Animation/AnimInstance.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/Pawn.h"
+#include "ActorPoolSubsystem.h"
+#include "ShooterBallistics.h"
+#include "ShooterProjectileReplicator.h"
+#include "ShooterProjectileTimings.h"
+#include "ShooterNoise.h"
+
+#include "UObject/ObjectSaveContext.h"
+#include "Misc/Guid.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 AShooterWeapon::AShooterWeapon()
 {
 	PrimaryActorTick.bCanEverTick = true;
+
+	// the fire loop only ticks while a full auto weapon is firing
+	FireLoopTick.bCanEverTick = true;
+	FireLoopTick.bStartWithTickEnabled = false;
+	FireLoopTick.TickGroup = TG_PrePhysics;
+
 	bReplicates = true;
 	SetReplicateMovement(false); // Ҫͬλ
 
@@ -38,29 +53,47 @@ AShooterWeapon::AShooterWeapon()
 	ThirdPersonMesh->bOwnerNoSee = true;
 }
 
+FShooterWeaponHolderChangedDelegate AShooterWeapon::OnWeaponHolderChanged;
+
 void AShooterWeapon::BeginPlay()
 {
-    Super::BeginPlay();
+	Super::BeginPlay();
 
-    // ȫõ Owner
-    if (AActor* MyOwner = GetOwner())
-    {
-        MyOwner->OnDestroyed.AddDynamic(this, &AShooterWeapon::OnOwnerDestroyed);
-        WeaponOwner = Cast<IShooterWeaponHolder>(MyOwner);
-        PawnOwner = Cast<APawn>(MyOwner);
-    }
+	// fill the first ammo clip
+	CurrentBullets = MagazineSize;
 
-    // fill the first ammo clip
-    CurrentBullets = MagazineSize;
+	// roll the seed every shot's random rolls derive from. Clients get it with the initial replication
+	if (HasAuthority())
+	{
+		// FMath::Rand only has 15 bits on some platforms, which would leave few enough seeds to search
+		WeaponSeed = static_cast<int32>(GetTypeHash(FGuid::NewGuid()));
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShooterWeapon, WeaponSeed, this);
+	}
 
-    if (WeaponOwner)
-    {
-        // attach the meshes to the owner
-        WeaponOwner->AttachWeaponMeshes(this);
+	// the server may have corrected our ammo before we began play
+	if (!HasAuthority() && AmmoCorrection.Sequence != 0)
+	{
+		ApplyAmmoCorrection();
+	}
 
-        // ʼһ HUDͻ˸Ƴǰ
-        WeaponOwner->UpdateWeaponHUD(CurrentBullets, MagazineSize);
-    }
+	// dedicated servers place shots with the analytic muzzle, so the weapon meshes never need to animate
+	if (GetNetMode() == NM_DedicatedServer && bHasBakedMuzzleOffset)
+	{
+		FirstPersonMesh->SetComponentTickEnabled(false);
+		ThirdPersonMesh->SetComponentTickEnabled(false);
+	}
+
+	// pre-spawn our projectiles on the server so firing doesn't have to spawn actors
+	if (HasAuthority() && FireMode == EShooterFireMode::Projectile)
+	{
+		if (UActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+		{
+			Pool->Prewarm(ProjectileClass, ProjectilePoolSize);
+		}
+	}
+
+	// attach to the owner and initialize its HUD, including on the copies replicated to clients
+	BindToOwner();
 }
 
 void AShooterWeapon::EndPlay(EEndPlayReason::Type EndPlayReason)
@@ -71,12 +104,158 @@ void AShooterWeapon::EndPlay(EEndPlayReason::Type EndPlayReason)
 	GetWorld()->GetTimerManager().ClearTimer(RefireTimer);
 }
 
+void FShooterWeaponFireTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (IsValid(Target) && TickType != LEVELTICK_ViewportsOnly)
+	{
+		FScopeCycleCounterUObject WeaponScope(Target);
+		Target->TickFireLoop(DeltaTime);
+	}
+}
+
+FString FShooterWeaponFireTickFunction::DiagnosticMessage()
+{
+	return GetNameSafe(Target) + TEXT("[FireLoopTick]");
+}
+
+FName FShooterWeaponFireTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return Target ? Target->GetClass()->GetFName() : NAME_None;
+}
+
+void AShooterWeapon::RegisterActorTickFunctions(bool bRegister)
+{
+	Super::RegisterActorTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		if (FireLoopTick.bCanEverTick)
+		{
+			FireLoopTick.Target = this;
+			FireLoopTick.SetTickFunctionEnable(FireLoopTick.bStartWithTickEnabled || FireLoopTick.IsTickFunctionEnabled());
+			FireLoopTick.RegisterTickFunction(GetLevel());
+		}
+
+	} else {
+
+		if (FireLoopTick.IsTickFunctionRegistered())
+		{
+			FireLoopTick.UnRegisterTickFunction();
+		}
+	}
+}
+
+void AShooterWeapon::TickFireLoop(float DeltaSeconds)
+{
+	// the loop only runs while a full auto weapon is firing
+	if (!bIsFiring || !bFullAuto)
+	{
+		FireLoopTick.SetTickFunctionEnable(false);
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const FVector MuzzleLocation = GetMuzzleLocation();
+
+	// pay off every shot owed up to now, placing each one where the muzzle was at the time it was owed
+	// after a hitch, shots past the per frame cap stay owed and get paid off over the next frames
+	ShotBatch.Reset();
+
+	while (NextFireTime <= Now && ShotBatch.Num() < MaxShotsPerFrame)
+	{
+		const float Age = FMath::Min(static_cast<float>(Now - NextFireTime), DeltaSeconds);
+		const float Alpha = DeltaSeconds > 0.0f ? 1.0f - Age / DeltaSeconds : 1.0f;
+
+		ShotBatch.Add({ FMath::Lerp(LastMuzzleLocation, MuzzleLocation, Alpha), Age });
+
+		TimeOfLastShot = NextFireTime;
+		NextFireTime += FMath::Max(RefireRate, UE_KINDA_SMALL_NUMBER);
+	}
+
+	LastMuzzleLocation = MuzzleLocation;
+
+	if (ShotBatch.Num() > 0)
+	{
+		FireShots(ShotBatch);
+	}
+}
+
 void AShooterWeapon::OnOwnerDestroyed(AActor* DestroyedActor)
 {
 	// ensure this weapon is destroyed when the owner is destroyed
 	Destroy();
 }
 
+void AShooterWeapon::BindToOwner()
+{
+	// stop listening to the previous owner
+	if (AActor* PreviousOwner = BoundOwner.Get())
+	{
+		PreviousOwner->OnDestroyed.RemoveDynamic(this, &AShooterWeapon::OnOwnerDestroyed);
+	}
+
+	AActor* MyOwner = GetOwner();
+
+	BoundOwner = MyOwner;
+	WeaponOwner = Cast<IShooterWeaponHolder>(MyOwner);
+	PawnOwner = Cast<APawn>(MyOwner);
+
+	// ensure this weapon is destroyed along with its owner
+	if (MyOwner)
+	{
+		MyOwner->OnDestroyed.AddUniqueDynamic(this, &AShooterWeapon::OnOwnerDestroyed);
+	}
+
+	if (WeaponOwner)
+	{
+		// attach the meshes to the owner
+		WeaponOwner->AttachWeaponMeshes(this);
+
+		// initialize the HUD
+		WeaponOwner->UpdateWeaponHUD(CurrentBullets, MagazineSize);
+
+	} else {
+
+		// we're being stored until a new holder picks us up
+		DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		SetActorHiddenInGame(true);
+	}
+}
+
+void AShooterWeapon::OnRep_Owner()
+{
+	Super::OnRep_Owner();
+
+	// the replicated copy may not have run BeginPlay yet, in which case it binds there
+	if (HasActorBegunPlay())
+	{
+		BindToOwner();
+	}
+}
+
+void AShooterWeapon::SetWeaponHolder(AActor* NewHolder)
+{
+	if (!HasAuthority() || NewHolder == GetOwner())
+	{
+		return;
+	}
+
+	// a stored weapon shouldn't keep firing
+	StopFiring();
+
+	AActor* OldHolder = GetOwner();
+
+	SetOwner(NewHolder);
+	SetInstigator(Cast<APawn>(NewHolder));
+
+	BindToOwner();
+
+	// give the new owner a baseline for its ammo predictions
+	CorrectAmmo(NextShotId);
+
+	OnWeaponHolderChanged.Broadcast(this, OldHolder, NewHolder);
+}
+
 void AShooterWeapon::ActivateWeapon()
 {
 	// unhide this weapon
@@ -114,10 +293,13 @@ void AShooterWeapon::StartFiring()
 
 	} else {
 
-		// if we're full auto, schedule the next shot
+		// if we're full auto, let the fire loop pick up the next shot when it's owed
 		if (bFullAuto)
 		{
-			GetWorld()->GetTimerManager().SetTimer(RefireTimer, this, &AShooterWeapon::Fire, TimeSinceLastShot, false);
+			NextFireTime = TimeOfLastShot + RefireRate;
+			LastMuzzleLocation = GetMuzzleLocation();
+
+			FireLoopTick.SetTickFunctionEnable(true);
 		}
 
 	}
@@ -128,8 +310,10 @@ void AShooterWeapon::StopFiring()
 	// lower the firing flag
 	bIsFiring = false;
 
-	// clear the refire timer
+	// clear the refire timer and stop the fire loop
 	GetWorld()->GetTimerManager().ClearTimer(RefireTimer);
+
+	FireLoopTick.SetTickFunctionEnable(false);
 }
 
 void AShooterWeapon::Fire()
@@ -140,20 +324,26 @@ void AShooterWeapon::Fire()
 		return;
 	}
 	
-	// fire a projectile at the target
-	FireProjectile(WeaponOwner->GetWeaponTargetLocation());
+	// fire a single shot from the current muzzle location
+	const FVector MuzzleLocation = GetMuzzleLocation();
+
+	ShotBatch.Reset();
+	ShotBatch.Add({ MuzzleLocation, 0.0f });
+
+	FireShots(ShotBatch);
 
 	// update the time of our last shot
 	TimeOfLastShot = GetWorld()->GetTimeSeconds();
 
-	// make noise so the AI perception system can hear us
-	MakeNoise(ShotLoudness, PawnOwner, PawnOwner->GetActorLocation(), ShotNoiseRange, ShotNoiseTag);
-
 	// are we full auto?
 	if (bFullAuto)
 	{
-		// schedule the next shot
-		GetWorld()->GetTimerManager().SetTimer(RefireTimer, this, &AShooterWeapon::Fire, RefireRate, false);
+		// the fire loop takes over from here and emits every following shot on the frame it's owed
+		NextFireTime = TimeOfLastShot + RefireRate;
+		LastMuzzleLocation = MuzzleLocation;
+
+		FireLoopTick.SetTickFunctionEnable(true);
+
 	} else {
 
 		// for semi-auto weapons, schedule the cooldown notification
@@ -168,54 +358,429 @@ void AShooterWeapon::FireCooldownExpired()
 	WeaponOwner->OnSemiWeaponRefire();
 }
 
-void AShooterWeapon::FireProjectile(const FVector& TargetLocation)
+void AShooterWeapon::FireShots(const TArray<FShooterWeaponShot>& Shots)
 {
-	// get the projectile transform
-	FTransform ProjectileTransform = CalculateProjectileSpawnTransform(TargetLocation);
-	
-	// spawn the projectile
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-	SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::OverrideRootScale;
-	SpawnParams.Owner = GetOwner();
-	SpawnParams.Instigator = PawnOwner;
+	// every shot in the batch aims at the same target
+	const FVector TargetLocation = WeaponOwner->GetWeaponTargetLocation();
 
-	AShooterProjectile* Projectile = GetWorld()->SpawnActor<AShooterProjectile>(ProjectileClass, ProjectileTransform, SpawnParams);
+	for (const FShooterWeaponShot& Shot : Shots)
+	{
+		FireProjectile(TargetLocation, Shot);
+	}
+
+	// confirm the whole batch to a predicting client at once
+	if (ShotConfirmations.Num() > 0)
+	{
+		ClientConfirmShots(ShotConfirmations);
+		ShotConfirmations.Reset();
+	}
+
+	// make noise so the AI perception system can hear us. AI only runs on the server
+	if (HasAuthority())
+	{
+		UShooterNoiseSubsystem::ReportNoise(this, ShotLoudness, PawnOwner, PawnOwner->GetActorLocation(), ShotNoiseRange, ShotNoiseTag);
+	}
 
 	// play the firing montage
 	WeaponOwner->PlayFiringMontage(FiringMontage);
 
-	// add recoil
-	WeaponOwner->AddWeaponRecoil(FiringRecoil);
-
-	// consume bullets
-	--CurrentBullets;
+	// add the recoil for every shot in the batch, rolling each shot's variance from its own stream
+	float Recoil = 0.0f;
 
-	// if the clip is depleted, reload it
-	if (CurrentBullets <= 0)
+	for (int32 i = 0; i < Shots.Num(); ++i)
 	{
-		CurrentBullets = MagazineSize;
+		const uint16 ShotId = static_cast<uint16>(NextShotId - Shots.Num() + i);
+		Recoil += FiringRecoil * GetShotStream(ShotId, EShooterShotStream::Recoil).FRandRange(1.0f - RecoilVariance, 1.0f + RecoilVariance);
 	}
 
+	WeaponOwner->AddWeaponRecoil(Recoil);
+
 	// update the weapon HUD
 	WeaponOwner->UpdateWeaponHUD(CurrentBullets, MagazineSize);
 }
 
-FTransform AShooterWeapon::CalculateProjectileSpawnTransform(const FVector& TargetLocation) const
+void AShooterWeapon::FireProjectile(const FVector& TargetLocation, const FShooterWeaponShot& Shot)
 {
-	// find the muzzle location
-	const FVector MuzzleLoc = FirstPersonMesh->GetSocketLocation(MuzzleSocketName);
+	// number this shot so the predicted and authoritative copies can be matched
+	const uint16 ShotId = NextShotId++;
+
+	// the spread seed comes from the weapon seed and the shot id, so the owning client predicts the same spread the server fires
+	const int32 Seed = GetShotStream(ShotId, EShooterShotStream::Spread).GetInitialSeed();
+
+	// get the projectile transform
+	FTransform ProjectileTransform = CalculateProjectileSpawnTransform(Shot.MuzzleLocation, TargetLocation, Seed);
+
+	if (IsPredictingShots())
+	{
+		// the owning client shows the shot right away. The server fires the real one
+		FirePredictedShot(ShotId, ProjectileTransform, Shot.Age);
+
+	} else if (FireMode == EShooterFireMode::Hitscan)
+	{
+		const FVector TraceStart = ProjectileTransform.GetLocation();
+		const FVector TraceEnd = TraceStart + ProjectileTransform.GetRotation().GetForwardVector() * HitscanRange;
+
+		// queue the shot so it's traced along with every other hitscan shot this frame
+		if (UShooterBallisticsSubsystem* Ballistics = GetWorld()->GetSubsystem<UShooterBallisticsSubsystem>())
+		{
+			// rewind the targets to what the shooting client was seeing when the shot was owed
+			const double RewindTime = LagCompensationOffset > 0.0f ? GetWorld()->GetTimeSeconds() - LagCompensationOffset - Shot.Age : 0.0;
+
+			Ballistics->FireHitscan(ProjectileClass, TraceStart, TraceEnd, GetOwner(), PawnOwner, this, RewindTime);
+		}
+
+		// let clients draw the tracer. Every shot this frame goes out in the same event array update
+		if (AShooterProjectileReplicator* Replicator = AShooterProjectileReplicator::Get(GetWorld()))
+		{
+			Replicator->AddTracerEvent(this, TraceStart, TraceEnd);
+		}
+
+	} else if (FireMode == EShooterFireMode::Simulated)
+	{
+		// hand the round over to the ballistics subsystem. No actor is spawned
+		if (UShooterBallisticsSubsystem* Ballistics = GetWorld()->GetSubsystem<UShooterBallisticsSubsystem>())
+		{
+			// let clients simulate a cosmetic copy of the round
+			AShooterProjectileReplicator* Replicator = AShooterProjectileReplicator::Get(GetWorld());
+			const uint32 ReplicationId = Replicator ? Replicator->AddSpawnEvent(ProjectileClass, PawnOwner, ProjectileTransform, Seed) : 0;
+
+			Ballistics->FireRound(ProjectileClass, ProjectileTransform, GetOwner(), PawnOwner, this, ReplicationId, LagCompensationOffset);
+		}
+
+	} else {
+
+		SHOOTER_PROJECTILE_PHASE_SCOPE(Spawn);
+
+		AShooterProjectile* Projectile = nullptr;
+
+		// get the projectile from the pool. It will only spawn a new one if the pool is dry
+		if (UActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+		{
+			Projectile = Pool->Acquire<AShooterProjectile>(ProjectileClass, ProjectileTransform, GetOwner(), PawnOwner);
+
+		} else {
+
+			// no pool in this world, so spawn the projectile directly. It's destroyed when it's released
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::OverrideRootScale;
+			SpawnParams.Owner = GetOwner();
+			SpawnParams.Instigator = PawnOwner;
+
+			Projectile = GetWorld()->SpawnActor<AShooterProjectile>(ProjectileClass, ProjectileTransform, SpawnParams);
+		}
+
+		if (Projectile)
+		{
+			Projectile->InitializeShot(ShotId, false);
+
+			// hit characters where the shooting client was seeing them
+			Projectile->SetRewindOffset(LagCompensationOffset);
+
+			// move the projectile forward by the part of the frame it should already have been flying
+			Projectile->CatchUp(Shot.Age);
+
+			// the projectile actor isn't replicated. Clients simulate their own copy from the spawn event
+			if (AShooterProjectileReplicator* Replicator = AShooterProjectileReplicator::Get(GetWorld()))
+			{
+				Projectile->SetReplicationId(Replicator->AddSpawnEvent(ProjectileClass, PawnOwner, ProjectileTransform, Seed));
+			}
+		}
+	}
 
+	// let a predicting client know where this shot actually went. Hitscan shots have nothing to reconcile
+	if (HasAuthority() && FireMode != EShooterFireMode::Hitscan && PawnOwner && PawnOwner->IsPlayerControlled() && !PawnOwner->IsLocallyControlled())
+	{
+		FShooterShotConfirmation& Confirmation = ShotConfirmations.AddDefaulted_GetRef();
+		Confirmation.ShotId = ShotId;
+		Confirmation.Origin = ProjectileTransform.GetLocation();
+		Confirmation.Direction = ProjectileTransform.GetRotation().GetForwardVector();
+	}
+
+	// consume bullets, reloading if the clip is depleted. The owning client predicts this the same way
+	CurrentBullets = ConsumeBullets(CurrentBullets, 1, MagazineSize);
+}
+
+int32 AShooterWeapon::ConsumeBullets(int32 Bullets, int32 NumShots, int32 MagazineSize)
+{
+	for (int32 i = 0; i < NumShots; ++i)
+	{
+		if (--Bullets <= 0)
+		{
+			Bullets = MagazineSize;
+		}
+	}
+
+	return Bullets;
+}
+
+bool AShooterWeapon::SyncShotPrediction(uint16 FirstShotId, int32 PredictedBullets)
+{
+	// the client can only be ahead of us, by the shots it predicted that we never fired. Signed so the counter can wrap around
+	const int32 ShotIdLead = static_cast<int16>(FirstShotId - NextShotId);
+
+	// ids we already fired, or ids far ahead, would let the client pick the spread rolls it likes best
+	if (ShotIdLead < 0 || ShotIdLead > MaxShotIdLead)
+	{
+		return false;
+	}
+
+	// skip the ids the client spent on shots we never fired. The counter only ever moves forward
+	NextShotId = FirstShotId;
+
+	// the client's count only drifts when a shot was fired on one side but not the other
+	if (PredictedBullets != CurrentBullets)
+	{
+		CorrectAmmo(FirstShotId);
+	}
+
+	return true;
+}
+
+void AShooterWeapon::RejectShots(uint16 FirstRejectedShotId)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	// the client drops its predictions and carries on from our counter
+	ClientRejectShots(FirstRejectedShotId, NextShotId);
+	CorrectAmmo(NextShotId);
+}
+
+void AShooterWeapon::CorrectAmmo(uint16 ShotId)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	AmmoCorrection.Bullets = CurrentBullets;
+	AmmoCorrection.ShotId = ShotId;
+	++AmmoCorrection.Sequence;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShooterWeapon, AmmoCorrection, this);
+}
+
+FRandomStream AShooterWeapon::GetShotStream(uint16 ShotId, EShooterShotStream Stream) const
+{
+	const uint32 ShotHash = HashCombine(HashCombine(GetTypeHash(WeaponSeed), GetTypeHash(ShotId)), GetTypeHash(static_cast<uint8>(Stream)));
+
+	return FRandomStream(static_cast<int32>(ShotHash));
+}
+
+FVector AShooterWeapon::GetMuzzleLocation() const
+{
+	// the owning player sees the animated first person mesh, so its shots leave from the visual socket
+	const bool bOwningPlayer = PawnOwner && PawnOwner->IsPlayerControlled() && PawnOwner->IsLocallyControlled();
+
+	FVector MuzzleLocation;
+	if (!bOwningPlayer && GetAnalyticMuzzleLocation(MuzzleLocation))
+	{
+		return MuzzleLocation;
+	}
+
+	return FirstPersonMesh->GetSocketLocation(MuzzleSocketName);
+}
+
+bool AShooterWeapon::GetAnalyticMuzzleLocation(FVector& OutMuzzleLocation) const
+{
+	FTransform WeaponSocket;
+	if (!bHasBakedMuzzleOffset || !WeaponOwner || !WeaponOwner->GetBakedWeaponSocket(WeaponSocket))
+	{
+		return false;
+	}
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	WeaponOwner->GetWeaponAimView(ViewLocation, ViewRotation);
+
+	// muzzle to weapon socket, weapon socket to aim view, aim view to world
+	OutMuzzleLocation = (WeaponSocket * FTransform(ViewRotation, ViewLocation)).TransformPosition(BakedMuzzleOffset);
+	return true;
+}
+
+#if WITH_EDITOR
+void AShooterWeapon::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	BakeMuzzleOffset();
+}
+
+void AShooterWeapon::BakeMuzzleOffset()
+{
+	// the mesh is snapped onto the holder's weapon socket, so the muzzle only needs to be in mesh space
+	FTransform MuzzleTransform;
+	bHasBakedMuzzleOffset = FirstPersonMesh && IShooterWeaponHolder::GetRefPoseSocketTransform(FirstPersonMesh->GetSkeletalMeshAsset(), MuzzleSocketName, MuzzleTransform);
+	BakedMuzzleOffset = bHasBakedMuzzleOffset ? MuzzleTransform.GetLocation() : FVector::ZeroVector;
+}
+#endif
+
+FTransform AShooterWeapon::CalculateProjectileSpawnTransform(const FVector& MuzzleLoc, const FVector& TargetLocation, int32 Seed) const
+{
 	// calculate the spawn location ahead of the muzzle
 	const FVector SpawnLoc = MuzzleLoc + ((TargetLocation - MuzzleLoc).GetSafeNormal() * MuzzleOffset);
 
 	// find the aim rotation vector while applying some variance to the target 
-	const FRotator AimRot = UKismetMathLibrary::FindLookAtRotation(SpawnLoc, TargetLocation + (UKismetMathLibrary::RandomUnitVector() * AimVariance));
+	const FRandomStream SpreadStream(Seed);
+	const FRotator AimRot = UKismetMathLibrary::FindLookAtRotation(SpawnLoc, TargetLocation + (SpreadStream.VRand() * AimVariance));
 
 	// return the built transform
 	return FTransform(AimRot, SpawnLoc, FVector::OneVector);
 }
 
+bool AShooterWeapon::IsPredictingShots() const
+{
+	return !HasAuthority() && PawnOwner && PawnOwner->IsLocallyControlled();
+}
+
+void AShooterWeapon::FirePredictedShot(uint16 ShotId, const FTransform& ShotTransform, float ShotAge)
+{
+	// hitscan shots have no projectile to show, so we only need the tracer
+	if (FireMode == EShooterFireMode::Hitscan)
+	{
+		const FVector TraceStart = ShotTransform.GetLocation();
+		DrawHitscanTracer(TraceStart, TraceStart + ShotTransform.GetRotation().GetForwardVector() * HitscanRange);
+		return;
+	}
+
+	ExpirePredictedShots();
+
+	// show a local cosmetic projectile for both projectile and simulated shots
+	UActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+	AShooterProjectile* Projectile = Pool ? Pool->Acquire<AShooterProjectile>(ProjectileClass, ShotTransform, GetOwner(), PawnOwner) : nullptr;
+
+	if (Projectile)
+	{
+		Projectile->InitializeShot(ShotId, true);
+		Projectile->CatchUp(ShotAge);
+	}
+
+	PredictedShots.Add({ ShotId, static_cast<float>(GetWorld()->GetTimeSeconds() - ShotAge), ShotTransform.GetLocation(), ShotTransform.GetRotation().GetForwardVector(), Projectile });
+}
+
+void AShooterWeapon::ExpirePredictedShots()
+{
+	const float ExpireTime = GetWorld()->GetTimeSeconds() - PredictedShotTimeout;
+
+	// the confirmation was probably dropped. The projectile keeps flying, we just stop tracking it
+	PredictedShots.RemoveAllSwap([ExpireTime](const FPredictedShot& Shot) { return Shot.FireTime < ExpireTime; }, EAllowShrinking::No);
+}
+
+void AShooterWeapon::ClientConfirmShots_Implementation(const TArray<FShooterShotConfirmation>& Confirmations)
+{
+	for (const FShooterShotConfirmation& Confirmation : Confirmations)
+	{
+		ConfirmShot(Confirmation);
+	}
+}
+
+void AShooterWeapon::ConfirmShot(const FShooterShotConfirmation& Confirmation)
+{
+	const uint16 ShotId = Confirmation.ShotId;
+	const FVector Origin = Confirmation.Origin;
+	const FVector Direction = Confirmation.Direction;
+
+	const int32 ShotIndex = PredictedShots.IndexOfByPredicate([ShotId](const FPredictedShot& Shot) { return Shot.ShotId == ShotId; });
+
+	if (ShotIndex == INDEX_NONE)
+	{
+		// the server fired a shot we didn't predict. Show it late
+		if (UActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UActorPoolSubsystem>())
+		{
+			if (AShooterProjectile* Projectile = Pool->Acquire<AShooterProjectile>(ProjectileClass, FTransform(Direction.Rotation(), Origin), GetOwner(), PawnOwner))
+			{
+				Projectile->InitializeShot(ShotId, true);
+			}
+		}
+
+		return;
+	}
+
+	const FPredictedShot Shot = PredictedShots[ShotIndex];
+	PredictedShots.RemoveAtSwap(ShotIndex, 1, EAllowShrinking::No);
+
+	// make sure the pooled projectile hasn't been reused for another shot
+	AShooterProjectile* Projectile = Shot.Projectile.Get();
+	if (!Projectile || !Projectile->IsCosmetic() || Projectile->GetShotId() != ShotId)
+	{
+		return;
+	}
+
+	// only correct noticeable mispredictions so small differences don't make the projectile pop
+	const bool bOriginDiverged = FVector::DistSquared(Shot.Origin, Origin) > FMath::Square(ReconcileDistance);
+	const bool bDirectionDiverged = FVector::DotProduct(Shot.Direction, Direction) < FMath::Cos(FMath::DegreesToRadians(ReconcileAngle));
+
+	if (bOriginDiverged || bDirectionDiverged)
+	{
+		Projectile->ReconcileTrajectory(Origin, Direction, GetWorld()->GetTimeSeconds() - Shot.FireTime);
+	}
+}
+
+void AShooterWeapon::ClientRejectShots_Implementation(uint16 FirstRejectedShotId, uint16 ServerNextShotId)
+{
+	// stop predicting shots the server won't fire
+	StopFiring();
+
+	for (int32 i = PredictedShots.Num() - 1; i >= 0; --i)
+	{
+		const FPredictedShot& Shot = PredictedShots[i];
+
+		// compare ids as a signed difference so the counter can wrap around
+		if (static_cast<int16>(Shot.ShotId - FirstRejectedShotId) >= 0)
+		{
+			AShooterProjectile* Projectile = Shot.Projectile.Get();
+			if (Projectile && Projectile->IsCosmetic() && Projectile->GetShotId() == Shot.ShotId)
+			{
+				UActorPoolSubsystem::ReleaseOrDestroy(Projectile);
+			}
+
+			PredictedShots.RemoveAtSwap(i, 1, EAllowShrinking::No);
+		}
+	}
+
+	// carry on from the server's counter. It never hands out an id twice
+	NextShotId = ServerNextShotId;
+
+	// give back the ammo of the rejected shots
+	ApplyAmmoCorrection();
+}
+
+void AShooterWeapon::PlayReplicatedTracer(const FVector& TraceStart, const FVector& TraceEnd)
+{
+	// tracers are purely cosmetic, so dedicated servers skip them
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	// the shooting client already drew its predicted tracer
+	if (IsPredictingShots())
+	{
+		return;
+	}
+
+	DrawHitscanTracer(TraceStart, TraceEnd);
+}
+
+void AShooterWeapon::DrawHitscanTracer(const FVector& TraceStart, const FVector& TraceEnd)
+{
+	// shorten the tracer to the first visible surface. This trace is local and never affects gameplay
+	FVector TracerEnd = TraceEnd;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterHitscanTracer), false, this);
+	QueryParams.AddIgnoredActor(GetOwner());
+
+	FHitResult Hit;
+	if (GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, ECC_Visibility, QueryParams))
+	{
+		TracerEnd = Hit.ImpactPoint;
+	}
+
+	BP_OnHitscanTracer(TraceStart, TracerEnd);
+}
+
 const TSubclassOf<UAnimInstance>& AShooterWeapon::GetFirstPersonAnimInstanceClass() const
 {
 	return FirstPersonAnimInstanceClass;
@@ -226,8 +791,25 @@ const TSubclassOf<UAnimInstance>& AShooterWeapon::GetThirdPersonAnimInstanceClas
 	return ThirdPersonAnimInstanceClass;
 }
 
-void AShooterWeapon::OnRep_CurrentBullets()
+void AShooterWeapon::OnRep_AmmoCorrection()
+{
+	// the correction will be applied on BeginPlay
+	if (HasActorBegunPlay())
+	{
+		ApplyAmmoCorrection();
+	}
+}
+
+void AShooterWeapon::ApplyAmmoCorrection()
 {
+	// replay the shots we predicted after the corrected one. Signed so the counter can wrap around
+	const int32 ShotsSinceCorrection = FMath::Max(0, static_cast<int32>(static_cast<int16>(NextShotId - AmmoCorrection.ShotId)));
+
+	// until the server corrects us, we count from the full magazine the weapon spawned with
+	const int32 CorrectedBullets = AmmoCorrection.Sequence != 0 ? AmmoCorrection.Bullets : MagazineSize;
+
+	CurrentBullets = ConsumeBullets(CorrectedBullets, ShotsSinceCorrection, MagazineSize);
+
 	if (WeaponOwner)
 	{
 		WeaponOwner->UpdateWeaponHUD(CurrentBullets, MagazineSize);
@@ -238,6 +820,15 @@ void AShooterWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLi
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShooterWeapon, CurrentBullets);
+	FDoRepLifetimeParams OwnerOnlyParams;
+	OwnerOnlyParams.bIsPushBased = true;
+	OwnerOnlyParams.Condition = COND_OwnerOnly;
+
+	FDoRepLifetimeParams InitialOnlyParams;
+	InitialOnlyParams.bIsPushBased = true;
+	InitialOnlyParams.Condition = COND_InitialOnly;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterWeapon, AmmoCorrection, OwnerOnlyParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShooterWeapon, WeaponSeed, InitialOnlyParams);
 }
 
@@ -14,6 +14,127 @@ class AShooterProjectile;
 class USkeletalMeshComponent;
 class UAnimMontage;
 class UAnimInstance;
+class AShooterWeapon;
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FShooterWeaponHolderChangedDelegate, AShooterWeapon*, AActor* /*OldHolder*/, AActor* /*NewHolder*/);
+
+/**
+ *  How a weapon delivers its shots
+ */
+UENUM(BlueprintType)
+enum class EShooterFireMode : uint8
+{
+	/** Spawns a pooled projectile actor for every shot */
+	Projectile,
+
+	/** Fires data-only rounds simulated by the ballistics subsystem. No actor is spawned */
+	Simulated,
+
+	/** Resolves the shot with a single async trace, batched with the frame's other hitscan shots and resolved on the next frame */
+	Hitscan
+};
+
+/**
+ *  Authoritative ammo count at a given shot
+ *  Only sent to the owning client, and only when its predicted ammo diverged from the server's
+ */
+USTRUCT()
+struct FShooterAmmoCorrection
+{
+	GENERATED_BODY()
+
+	/** Bullets in the magazine before the shot was fired */
+	UPROPERTY()
+	int32 Bullets = 0;
+
+	/** Id of the shot the count applies to */
+	UPROPERTY()
+	uint16 ShotId = 0;
+
+	/** Bumped on every correction so the same count can be sent twice */
+	UPROPERTY()
+	uint8 Sequence = 0;
+};
+
+/**
+ *  Where the server actually fired one of the owning client's predicted shots
+ */
+USTRUCT()
+struct FShooterShotConfirmation
+{
+	GENERATED_BODY()
+
+	/** Id of the confirmed shot */
+	UPROPERTY()
+	uint16 ShotId = 0;
+
+	/** Launch location on the server */
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	/** Launch direction on the server */
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction;
+};
+
+/**
+ *  Independent random streams drawn for every shot
+ *  Each one is keyed by the weapon seed and the shot id, so every machine rolls the same numbers for the same shot
+ */
+enum class EShooterShotStream : uint8
+{
+	/** Aim spread around the target */
+	Spread,
+
+	/** Aim jitter added by the weapon holder */
+	Aim,
+
+	/** Recoil variance */
+	Recoil
+};
+
+/**
+ *  A single shot emitted by the weapon fire loop
+ */
+struct FShooterWeaponShot
+{
+	/** Muzzle location at the moment the shot was owed, interpolated across the frame */
+	FVector MuzzleLocation = FVector::ZeroVector;
+
+	/** Time between the moment the shot was owed and the end of the frame */
+	float Age = 0.0f;
+};
+
+/**
+ *  Tick function that runs the full auto fire loop
+ *  Kept apart from the actor tick so the loop can be switched on and off without touching Event Tick
+ */
+USTRUCT()
+struct FShooterWeaponFireTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** Weapon that owns this tick function */
+	AShooterWeapon* Target = nullptr;
+
+	/** Runs the fire loop on the target weapon */
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	/** Describes the tick function for debugging */
+	virtual FString DiagnosticMessage() override;
+
+	/** Describes the tick function for the tick stats */
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterWeaponFireTickFunction> : public TStructOpsTypeTraitsBase2<FShooterWeaponFireTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
 
 /**
  *  Base class for a simple first person shooter weapon
@@ -43,13 +164,28 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Ammo")
 	TSubclassOf<AShooterProjectile> ProjectileClass;
 
+	/** How this weapon delivers its shots. Simulated rounds still read their settings from the projectile class */
+	UPROPERTY(EditAnywhere, Category="Ammo")
+	EShooterFireMode FireMode = EShooterFireMode::Projectile;
+
+	/** Max trace distance for hitscan shots */
+	UPROPERTY(EditAnywhere, Category="Ammo", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm", EditCondition = "FireMode == EShooterFireMode::Hitscan"))
+	float HitscanRange = 10000.0f;
+
+	/** Number of projectiles to pre-spawn in the projectile pool when this weapon is created. Only used in Projectile fire mode */
+	UPROPERTY(EditAnywhere, Category="Ammo", meta = (ClampMin = 0, ClampMax = 200))
+	int32 ProjectilePoolSize = 20;
+
 	/** Number of bullets in a magazine */
 	UPROPERTY(EditAnywhere, Category="Ammo", meta = (ClampMin = 0, ClampMax = 100))
 	int32 MagazineSize = 10;
 
-	/** Number of bullets in the current magazine */
-	UPROPERTY(ReplicatedUsing = OnRep_CurrentBullets)
+	/** Number of bullets in the current magazine. Predicted by the owning client, authoritative on the server */
 	int32 CurrentBullets = 0;
+
+	/** Last ammo correction sent by the server. Only replicated to the owner */
+	UPROPERTY(ReplicatedUsing = OnRep_AmmoCorrection)
+	FShooterAmmoCorrection AmmoCorrection;
 	
 	/** Animation montage to play when firing this weapon */
 	UPROPERTY(EditAnywhere, Category="Animation")
@@ -71,6 +207,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Aim", meta = (ClampMin = 0, ClampMax = 100))
 	float FiringRecoil = 0.0f;
 
+	/** Random variance applied to the recoil of every shot, as a fraction of the firing recoil */
+	UPROPERTY(EditAnywhere, Category="Aim", meta = (ClampMin = 0, ClampMax = 1))
+	float RecoilVariance = 0.0f;
+
 	/** Name of the first person muzzle socket where projectiles will spawn */
 	UPROPERTY(EditAnywhere, Category="Aim")
 	FName MuzzleSocketName;
@@ -79,6 +219,14 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Aim", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm"))
 	float MuzzleOffset = 10.0f;
 
+	/** Muzzle socket location in the first person mesh reference pose, relative to the point the mesh is attached at. Baked when the weapon is saved */
+	UPROPERTY(VisibleAnywhere, Category="Aim", meta = (Units = "cm"))
+	FVector BakedMuzzleOffset = FVector::ZeroVector;
+
+	/** If true, the muzzle offset has been baked */
+	UPROPERTY(VisibleAnywhere, Category="Aim")
+	bool bHasBakedMuzzleOffset = false;
+
 	/** If true, this weapon will automatically fire at the refire rate */
 	UPROPERTY(EditAnywhere, Category="Refire")
 	bool bFullAuto = false;
@@ -87,18 +235,81 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Refire", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
 	float RefireRate = 0.5f;
 
+	/** Max number of shots the full auto fire loop can emit in a single frame. Shots owed past this after a hitch carry over to the next frames */
+	UPROPERTY(EditAnywhere, Category="Refire", meta = (ClampMin = 1, ClampMax = 64))
+	int32 MaxShotsPerFrame = 8;
+
 	/** Game time of last shot fired, used to enforce refire rate on semi auto */
 	float TimeOfLastShot = 0.0f;
 
+	/** Game time the next full auto shot is owed at. The fire loop pays off every shot owed up to the current time each tick */
+	double NextFireTime = 0.0;
+
+	/** Muzzle location at the end of the last tick. Owed shots interpolate from here to the current muzzle location */
+	FVector LastMuzzleLocation = FVector::ZeroVector;
+
+	/** Shots emitted this frame, handed to the spawner as a single batch */
+	TArray<FShooterWeaponShot> ShotBatch;
+
+	/** Confirmations for the shots fired this frame, sent to the predicting client in a single RPC */
+	TArray<FShooterShotConfirmation> ShotConfirmations;
+
+	/** Runs the full auto fire loop. Only enabled while a full auto weapon is firing */
+	FShooterWeaponFireTickFunction FireLoopTick;
+
+	friend struct FShooterWeaponFireTickFunction;
+
 	/** If true, the weapon is currently firing */
 	bool bIsFiring = false;
 
+	/** How far behind the server the shooting client is seeing the world. Used to rewind the characters hit by its shots */
+	float LagCompensationOffset = 0.0f;
+
+	/** Id that will be given to the next shot. The owning client and the server count shots in lockstep, but only the server's counter is trusted */
+	uint16 NextShotId = 0;
+
+	/** Rolled by the server when the weapon spawns. Combined with the shot id to seed every random roll of a shot */
+	UPROPERTY(Replicated)
+	int32 WeaponSeed = 0;
+
+	/** A shot the owning client fired locally and is waiting for the server to confirm */
+	struct FPredictedShot
+	{
+		uint16 ShotId;
+		float FireTime;
+		FVector Origin;
+		FVector Direction;
+		TWeakObjectPtr<AShooterProjectile> Projectile;
+	};
+
+	/** Shots fired locally by the owning client that the server hasn't confirmed yet */
+	TArray<FPredictedShot> PredictedShots;
+
+	/** Time after which an unconfirmed predicted shot is forgotten */
+	UPROPERTY(EditAnywhere, Category="Prediction", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float PredictedShotTimeout = 1.0f;
+
+	/** Predicted projectiles that spawned further than this from the server shot get moved onto the server trajectory */
+	UPROPERTY(EditAnywhere, Category="Prediction", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm"))
+	float ReconcileDistance = 30.0f;
+
+	/** Predicted projectiles aimed further off than this from the server shot get moved onto the server trajectory */
+	UPROPERTY(EditAnywhere, Category="Prediction", meta = (ClampMin = 0, ClampMax = 90, Units = "Degrees"))
+	float ReconcileAngle = 2.0f;
+
+	/** How far ahead of the server's shot counter a client may start firing. Covers shots it predicted that the server never fired */
+	UPROPERTY(EditAnywhere, Category="Prediction", meta = (ClampMin = 0, ClampMax = 32))
+	int32 MaxShotIdLead = 4;
+
 	/** Timer to handle full auto refiring */
 	FTimerHandle RefireTimer;
 
 	/** Cast pawn pointer to the owner for AI perception system interactions */
 	TObjectPtr<APawn> PawnOwner;
 
+	/** Owner we're listening to for destruction. Kept so we can stop listening when the weapon changes hands */
+	TWeakObjectPtr<AActor> BoundOwner;
+
 	/** Loudness of the shot for AI perception system interactions */
 	UPROPERTY(EditAnywhere, Category="Perception", meta = (ClampMin = 0, ClampMax = 100))
 	float ShotLoudness = 1.0f;
@@ -124,14 +335,40 @@ protected:
 	/** Gameplay Cleanup */
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
+	/** Registers the fire loop tick function alongside the actor tick */
+	virtual void RegisterActorTickFunctions(bool bRegister) override;
+
+	/** Pays off every full auto shot owed up to now */
+	void TickFireLoop(float DeltaSeconds);
+
+#if WITH_EDITOR
+	/** Bakes the muzzle offset so cooked builds never need to evaluate the mesh for it */
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+
+	/** Reads the muzzle socket location from the first person mesh reference pose */
+	void BakeMuzzleOffset();
+#endif
+
 protected:
 
 	/** Called when the weapon's owner is destroyed */
 	UFUNCTION()
 	void OnOwnerDestroyed(AActor* DestroyedActor);
 
+	/** Picks up the current owner as the weapon holder. Attaches to it if it's a holder, otherwise detaches and hides */
+	void BindToOwner();
+
+	/** Rebinds to the new owner on clients */
+	virtual void OnRep_Owner() override;
+
 public:
 
+	/** Hands this weapon to a new owner. Passing an actor that isn't a weapon holder, such as a controller, stores the weapon detached and hidden. Server only */
+	void SetWeaponHolder(AActor* NewHolder);
+
+	/** Called on the server whenever a weapon changes hands, so the replication graph can move it to its new holder */
+	static FShooterWeaponHolderChangedDelegate OnWeaponHolderChanged;
+
 	/** Activates this weapon and gets it ready to fire */
 	void ActivateWeapon();
 
@@ -144,8 +381,39 @@ public:
 	/** Stop firing this weapon */
 	void StopFiring();
 
+	/** Sets how far shots should be rewound for lag compensation. Server only */
+	void SetLagCompensationOffset(float Offset) { LagCompensationOffset = Offset; }
+
+	/** Returns the id the next shot will use */
+	uint16 GetNextShotId() const { return NextShotId; }
+
+	/** Returns the random stream for one of a shot's rolls. Every machine gets the same stream for the same weapon and shot */
+	FRandomStream GetShotStream(uint16 ShotId, EShooterShotStream Stream) const;
+
+	/**
+	 *  Syncs the shot counter with the one the owning client sent when it started firing, and corrects its ammo if it predicted a different count. Server only
+	 *  @return false if the id is behind the server's counter or too far ahead of it. The counter is left alone and the shots should be rejected
+	 */
+	bool SyncShotPrediction(uint16 FirstShotId, int32 PredictedBullets);
+
+	/** Refuses the owning client's shots starting at the given id and resyncs its shot counter and ammo. Server only */
+	void RejectShots(uint16 FirstRejectedShotId);
+
+	/** Sends the owning client the current ammo count as of the given shot. Server only */
+	void CorrectAmmo(uint16 ShotId);
+
+	/** Tells the owning client the server refused its shots, starting at the given id, and where the server's shot counter is */
+	UFUNCTION(Client, Reliable)
+	void ClientRejectShots(uint16 FirstRejectedShotId, uint16 ServerNextShotId);
+
 	UFUNCTION()
-	void OnRep_CurrentBullets();
+	void OnRep_AmmoCorrection();
+
+	/** Rebuilds the predicted ammo count from the last correction by replaying the shots fired since */
+	void ApplyAmmoCorrection();
+
+	/** Returns the bullet count left after firing a number of shots, reloading whenever the magazine runs dry */
+	static int32 ConsumeBullets(int32 Bullets, int32 NumShots, int32 MagazineSize);
 
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
@@ -157,11 +425,44 @@ protected:
 	/** Called when the refire rate time has passed while shooting semi auto weapons */
 	void FireCooldownExpired();
 
+	/** Fires a batch of shots towards the owner's aim target, then plays the montage and updates the HUD once */
+	void FireShots(const TArray<FShooterWeaponShot>& Shots);
+
 	/** Fire a projectile towards the target location */
-	virtual void FireProjectile(const FVector& TargetLocation);
+	virtual void FireProjectile(const FVector& TargetLocation, const FShooterWeaponShot& Shot);
+
+	/** Returns the current muzzle location. Read from the analytic muzzle for everyone but the owning player, or from the animated socket if nothing was baked */
+	FVector GetMuzzleLocation() const;
+
+	/** Places the muzzle from the holder's aim view, its baked weapon socket and the baked muzzle offset. Returns false if either offset is missing */
+	bool GetAnalyticMuzzleLocation(FVector& OutMuzzleLocation) const;
+
+	/** Calculates the spawn transform for projectiles shot by this weapon. The seed drives the aim spread, see GetShotStream */
+	FTransform CalculateProjectileSpawnTransform(const FVector& MuzzleLocation, const FVector& TargetLocation, int32 Seed) const;
+
+	/** Returns true if this weapon is held by the locally controlled pawn on a client, so its shots are only predictions */
+	bool IsPredictingShots() const;
+
+	/** Shows a shot on the owning client right away, while the server fires the real one */
+	void FirePredictedShot(uint16 ShotId, const FTransform& ShotTransform, float ShotAge);
 
-	/** Calculates the spawn transform for projectiles shot by this weapon */
-	FTransform CalculateProjectileSpawnTransform(const FVector& TargetLocation) const;
+	/** Forgets predicted shots the server never confirmed */
+	void ExpirePredictedShots();
+
+	/** Tells the owning client where the server actually fired a batch of shots so it can fix its predictions */
+	UFUNCTION(Client, Unreliable)
+	void ClientConfirmShots(const TArray<FShooterShotConfirmation>& Confirmations);
+
+	/** Fixes the prediction of a single shot from the server's confirmation */
+	void ConfirmShot(const FShooterShotConfirmation& Confirmation);
+
+	/** Draws a cosmetic tracer for a hitscan shot, shortened to the first visible surface */
+	void DrawHitscanTracer(const FVector& TraceStart, const FVector& TraceEnd);
+
+
+	/** Passes control to Blueprint to draw a hitscan tracer. Only called on machines that render */
+	UFUNCTION(BlueprintImplementableEvent, Category="Weapon", meta = (DisplayName = "On Hitscan Tracer"))
+	void BP_OnHitscanTracer(const FVector& TraceStart, const FVector& TraceEnd);
 
 public:
 
@@ -184,4 +485,7 @@ public:
 
 	/** Returns the current bullet count */
 	int32 GetBulletCount() const { return CurrentBullets; }
+
+	/** Draws the tracer of a hitscan shot replicated by the server. Skipped where nothing renders or the shot was already predicted */
+	void PlayReplicatedTracer(const FVector& TraceStart, const FVector& TraceEnd);
 };
@@ -0,0 +1,13 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterWeaponDefinition.h"
+
+const FPrimaryAssetType UShooterWeaponDefinition::PrimaryAssetType(TEXT("ShooterWeapon"));
+const FName UShooterWeaponDefinition::PickupBundle(TEXT("Pickup"));
+const FName UShooterWeaponDefinition::EquipBundle(TEXT("Equip"));
+
+FPrimaryAssetId UShooterWeaponDefinition::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ShooterWeaponDefinition.generated.h"
+
+class UStaticMesh;
+class AShooterWeapon;
+
+/**
+ *  Primary asset describing a weapon that can be picked up
+ *  Every reference is soft so a definition can be kept in memory without pulling the weapon in with it
+ *  The assets are split in two bundles:
+ *  "Pickup" holds what a pickup needs to show itself
+ *  "Equip" holds the weapon class, which in turn hard references its projectile, anim instance classes, meshes and montages
+ */
+UCLASS(BlueprintType)
+class FIRSTPERSONDEMO_API UShooterWeaponDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Primary asset type used by every weapon definition. Must match the AssetManager settings */
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	/** Bundle with the assets a pickup displays */
+	static const FName PickupBundle;
+
+	/** Bundle with the assets needed to spawn and fire the weapon */
+	static const FName EquipBundle;
+
+	/** Mesh to display on the pickup */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Pickup", meta = (AssetBundles = "Pickup"))
+	TSoftObjectPtr<UStaticMesh> PickupMesh;
+
+	/** Weapon class to grant on pickup */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Weapon", meta = (AssetBundles = "Equip"))
+	TSoftClassPtr<AShooterWeapon> WeaponClass;
+
+	/** Identifies this asset to the AssetManager */
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+};
@@ -2,5 +2,75 @@
 
 
 #include "ShooterWeaponHolder.h"
+#include "GameFramework/Character.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
 
 // Add default functionality here for any IShooterWeaponHolder functions that are not pure virtual.
+
+bool IShooterWeaponHolder::GetBakedWeaponSocket(FTransform& OutSocketTransform) const
+{
+	return false;
+}
+
+#if WITH_EDITOR
+bool IShooterWeaponHolder::GetRefPoseSocketTransform(const USkeletalMesh* Mesh, FName SocketName, FTransform& OutTransform)
+{
+	if (!Mesh)
+	{
+		return false;
+	}
+
+	// sockets sit on a bone, plain bone names are used as they are
+	FTransform Transform = FTransform::Identity;
+	FName BoneName = SocketName;
+
+	if (const USkeletalMeshSocket* Socket = Mesh->FindSocket(SocketName))
+	{
+		Transform = Socket->GetSocketLocalTransform();
+		BoneName = Socket->BoneName;
+	}
+
+	const FReferenceSkeleton& RefSkeleton = Mesh->GetRefSkeleton();
+	const TArray<FTransform>& RefPose = RefSkeleton.GetRefBonePose();
+
+	int32 BoneIndex = RefSkeleton.FindBoneIndex(BoneName);
+
+	if (BoneIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// walk up the reference pose to get it in component space
+	for (; BoneIndex != INDEX_NONE; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
+	{
+		Transform *= RefPose[BoneIndex];
+	}
+
+	OutTransform = Transform;
+	return true;
+}
+
+bool IShooterWeaponHolder::BakeWeaponSocket(const ACharacter* Holder, const USkeletalMeshComponent* FirstPersonMesh, FName SocketName, FTransform& OutSocketTransform)
+{
+	FTransform SocketTransform;
+
+	if (!Holder || !FirstPersonMesh || !GetRefPoseSocketTransform(FirstPersonMesh->GetSkeletalMeshAsset(), SocketName, SocketTransform))
+	{
+		return false;
+	}
+
+	// bring the socket into actor space through the attachment chain. The first person mesh hangs off the character mesh
+	for (const USceneComponent* Component = FirstPersonMesh; Component && Component != Holder->GetRootComponent(); Component = Component->GetAttachParent())
+	{
+		SocketTransform *= Component->GetRelativeTransform();
+	}
+
+	// the eye view sits at the base eye height and faces along the actor, same as APawn::GetPawnViewLocation
+	const FTransform EyeView(FVector(0.0f, 0.0f, Holder->BaseEyeHeight));
+
+	OutSocketTransform = SocketTransform.GetRelativeTransform(EyeView);
+	return true;
+}
+#endif
@@ -8,6 +8,9 @@
 
 class AShooterWeapon;
 class UAnimMontage;
+class ACharacter;
+class USkeletalMesh;
+class USkeletalMeshComponent;
 
 
 // This class does not need to be modified.
@@ -41,6 +44,12 @@ public:
 	/** Calculates and returns the aim location for the weapon */
 	virtual FVector GetWeaponTargetLocation() = 0;
 
+	/** Returns the view the weapon is aimed from. Used to place the muzzle without reading animated sockets */
+	virtual void GetWeaponAimView(FVector& OutViewLocation, FRotator& OutViewRotation) = 0;
+
+	/** Returns the weapon socket relative to the aim view, baked from the holder's mesh. Returns false if there is no baked value */
+	virtual bool GetBakedWeaponSocket(FTransform& OutSocketTransform) const;
+
 	/** Gives a weapon of this class to the owner */
 	virtual void AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) = 0;
 
@@ -52,4 +61,12 @@ public:
 
 	/** Notifies the owner that the weapon cooldown has expired and it's ready to shoot again */
 	virtual void OnSemiWeaponRefire() = 0;
+
+#if WITH_EDITOR
+	/** Returns a socket or bone transform in component space, in the mesh reference pose */
+	static bool GetRefPoseSocketTransform(const USkeletalMesh* Mesh, FName SocketName, FTransform& OutTransform);
+
+	/** Bakes a first person mesh socket relative to the holder's eye view, in the mesh reference pose */
+	static bool BakeWeaponSocket(const ACharacter* Holder, const USkeletalMeshComponent* FirstPersonMesh, FName SocketName, FTransform& OutSocketTransform);
+#endif
 };
@@ -0,0 +1,166 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "ShooterWeaponStreaming.h"
+#include "ShooterWeaponDefinition.h"
+#include "ShooterPickup.h"
+#include "ShooterWeapon.h"
+#include "FirstPersonDemo.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+bool FShooterWeaponAssets::IsResident() const
+{
+	return (PickupMesh.IsNull() || PickupMesh.IsValid()) && (WeaponClass.IsNull() || WeaponClass.IsValid());
+}
+
+void FShooterWeaponAssets::GetAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	if (!PickupMesh.IsNull())
+	{
+		OutPaths.AddUnique(PickupMesh.ToSoftObjectPath());
+	}
+
+	if (!WeaponClass.IsNull())
+	{
+		OutPaths.AddUnique(WeaponClass.ToSoftObjectPath());
+	}
+}
+
+TSharedPtr<FStreamableHandle> UShooterWeaponStreamingSubsystem::RequestWeaponAssets(const FShooterWeaponAssets& Assets, FStreamableDelegate OnLoaded)
+{
+	// weapon definitions load through their bundles
+	if (Assets.DefinitionId.IsValid())
+	{
+		const TArray<FName> Bundles = { UShooterWeaponDefinition::PickupBundle, UShooterWeaponDefinition::EquipBundle };
+		return UAssetManager::Get().LoadPrimaryAsset(Assets.DefinitionId, Bundles, OnLoaded, FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	// pickups set up from the weapon data table load their paths directly
+	TArray<FSoftObjectPath> Paths;
+	Assets.GetAssetPaths(Paths);
+
+	if (Paths.Num() == 0)
+	{
+		OnLoaded.ExecuteIfBound();
+		return nullptr;
+	}
+
+	return UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths, OnLoaded, FStreamableManager::AsyncLoadHighPriority);
+}
+
+UObject* UShooterWeaponStreamingSubsystem::LoadSynchronous(const FSoftObjectPath& AssetPath, const UObject* Requester)
+{
+	if (AssetPath.IsNull())
+	{
+		return nullptr;
+	}
+
+	// already streamed in, nothing to do
+	if (UObject* LoadedAsset = AssetPath.ResolveObject())
+	{
+		return LoadedAsset;
+	}
+
+#if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+	UE_LOG(LogFirstPersonDemo, Error, TEXT("%s is synchronously loading %s. It should have been preloaded"), *GetNameSafe(Requester), *AssetPath.ToString());
+#endif
+
+	return UAssetManager::GetStreamableManager().LoadSynchronous(AssetPath);
+}
+
+void UShooterWeaponStreamingSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TArray<FPrimaryAssetId> DefinitionIds;
+	TArray<FSoftObjectPath> Paths;
+
+	// gather every weapon referenced by a pickup placed in the level
+	for (TActorIterator<AShooterPickup> It(&InWorld); It; ++It)
+	{
+		FShooterWeaponAssets Assets;
+
+		if (!It->GetWeaponAssets(Assets) || Assets.IsResident())
+		{
+			continue;
+		}
+
+		if (Assets.DefinitionId.IsValid())
+		{
+			DefinitionIds.AddUnique(Assets.DefinitionId);
+
+		} else {
+
+			Assets.GetAssetPaths(Paths);
+		}
+	}
+
+	PreloadStartTime = FPlatformTime::Seconds();
+
+	const FStreamableDelegate OnComplete = FStreamableDelegate::CreateUObject(this, &UShooterWeaponStreamingSubsystem::OnPreloadComplete);
+
+	if (DefinitionIds.Num() > 0)
+	{
+		const TArray<FName> Bundles = { UShooterWeaponDefinition::PickupBundle, UShooterWeaponDefinition::EquipBundle };
+
+		TrackPreload(UAssetManager::Get().LoadPrimaryAssets(DefinitionIds, Bundles, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority), OnComplete);
+	}
+
+	if (Paths.Num() > 0)
+	{
+		TrackPreload(UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority), OnComplete);
+	}
+
+	UE_CLOG(PendingPreloads > 0, LogFirstPersonDemo, Log, TEXT("Preloading %d weapon definitions and %d weapon assets"), DefinitionIds.Num(), Paths.Num());
+}
+
+void UShooterWeaponStreamingSubsystem::Deinitialize()
+{
+	for (const TSharedPtr<FStreamableHandle>& Handle : PreloadHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->ReleaseHandle();
+		}
+	}
+
+	PreloadHandles.Empty();
+	PendingPreloads = 0;
+
+	Super::Deinitialize();
+}
+
+bool UShooterWeaponStreamingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterWeaponStreamingSubsystem::TrackPreload(TSharedPtr<FStreamableHandle> Handle, const FStreamableDelegate& OnComplete)
+{
+	if (!Handle.IsValid())
+	{
+		return;
+	}
+
+	// hold on to the handle so the assets stay in memory
+	PreloadHandles.Add(Handle);
+
+	if (!Handle->HasLoadCompleted())
+	{
+		++PendingPreloads;
+		Handle->BindCompleteDelegate(OnComplete);
+	}
+}
+
+void UShooterWeaponStreamingSubsystem::OnPreloadComplete()
+{
+	if (--PendingPreloads > 0)
+	{
+		return;
+	}
+
+	UE_LOG(LogFirstPersonDemo, Log, TEXT("Weapon preload finished in %.2fs"), FPlatformTime::Seconds() - PreloadStartTime);
+}
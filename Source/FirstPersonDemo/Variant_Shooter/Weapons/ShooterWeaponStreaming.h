@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "ShooterWeaponStreaming.generated.h"
+
+class UStaticMesh;
+class AShooterWeapon;
+
+/**
+ *  Soft references to the assets behind a weapon pickup
+ */
+struct FShooterWeaponAssets
+{
+	/** Weapon definition the assets come from. Invalid for pickups still set up from the weapon data table */
+	FPrimaryAssetId DefinitionId;
+
+	/** Mesh to display on the pickup */
+	TSoftObjectPtr<UStaticMesh> PickupMesh;
+
+	/** Weapon class to grant on pickup */
+	TSoftClassPtr<AShooterWeapon> WeaponClass;
+
+	/** Returns true if both assets are already in memory */
+	bool IsResident() const;
+
+	/** Adds the asset paths to the list */
+	void GetAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+};
+
+/**
+ *  Streams in weapon assets ahead of time so picking up a weapon never stalls on a load
+ *  Every pickup placed in the level is preloaded asynchronously as soon as the world begins play, which covers the pre-game countdown
+ *  Runs on the server and on clients
+ */
+UCLASS()
+class FIRSTPERSONDEMO_API UShooterWeaponStreamingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Keeps the preloaded assets in memory for the lifetime of the world */
+	TArray<TSharedPtr<FStreamableHandle>> PreloadHandles;
+
+	/** Time the preload was requested, used to log how long it took */
+	double PreloadStartTime = 0.0;
+
+	/** Number of preload requests still streaming */
+	int32 PendingPreloads = 0;
+
+public:
+
+	/** Streams in the given weapon assets. The delegate is called on the game thread once they're loaded, or right away if they're already resident */
+	TSharedPtr<FStreamableHandle> RequestWeaponAssets(const FShooterWeaponAssets& Assets, FStreamableDelegate OnLoaded);
+
+	/** Loads an asset right away if it isn't resident yet. Development builds log this as an error since it means the preload missed it */
+	static UObject* LoadSynchronous(const FSoftObjectPath& AssetPath, const UObject* Requester);
+
+	/** Typed version of LoadSynchronous for soft class pointers */
+	template<typename T>
+	static UClass* LoadSynchronous(const TSoftClassPtr<T>& SoftClass, const UObject* Requester)
+	{
+		return Cast<UClass>(LoadSynchronous(SoftClass.ToSoftObjectPath(), Requester));
+	}
+
+	/** Typed version of LoadSynchronous for soft object pointers */
+	template<typename T>
+	static T* LoadSynchronous(const TSoftObjectPtr<T>& SoftObject, const UObject* Requester)
+	{
+		return Cast<T>(LoadSynchronous(SoftObject.ToSoftObjectPath(), Requester));
+	}
+
+protected:
+
+	/** Preloads the assets of every weapon pickup placed in the world */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Releases the preloaded assets */
+	virtual void Deinitialize() override;
+
+	/** Only runs in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Keeps a preload request alive and counts it until it completes */
+	void TrackPreload(TSharedPtr<FStreamableHandle> Handle, const FStreamableDelegate& OnComplete);
+
+	/** Logs the preload time once every request is in */
+	void OnPreloadComplete();
+};